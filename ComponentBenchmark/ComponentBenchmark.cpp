@@ -0,0 +1,327 @@
+// ComponentBenchmark.cpp : Defines the entry point for the microbenchmark console application.
+//
+// Results are written to stdout as CSV with one row per measurement:
+//	benchmark,component_size,components,active_percent,churn_percent,operations,ns_per_op
+//
+
+#include "stdafx.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "ComponentPool.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+/**
+*	A component of the given size that does a trivial amount of work per update.
+*/
+template <size_t SIZE>
+struct BenchmarkComponent
+{
+	BenchmarkComponent( )
+		: _value( 0.0f )
+		, _payload( ) // Zero the payload so moves and copies work on defined bytes
+	{
+
+	}
+
+	void Update( const float dt )
+	{
+		_value += dt;
+	}
+
+	float _value;
+
+	unsigned char _payload [ SIZE - sizeof( float ) ];
+};
+
+/**
+*	A high resolution stopwatch.
+*/
+class BenchmarkTimer
+{
+public:
+
+	BenchmarkTimer( )
+	{
+		Restart( );
+	}
+
+	/**
+	*	Starts timing from now.
+	*/
+	void Restart( )
+	{
+#ifdef _WIN32
+		QueryPerformanceCounter( &_start );
+#else
+		_start = std::chrono::steady_clock::now( );
+#endif
+	}
+
+	/**
+	*	Gets the time since the timer was started in nanoseconds.
+	*/
+	double Elapsed( ) const
+	{
+#ifdef _WIN32
+		LARGE_INTEGER now, frequency;
+		QueryPerformanceCounter( &now );
+		QueryPerformanceFrequency( &frequency );
+		return static_cast< double >( now.QuadPart - _start.QuadPart ) * 1e9 / static_cast< double >( frequency.QuadPart );
+#else
+		return std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now( ) - _start ).count( );
+#endif
+	}
+
+private:
+
+#ifdef _WIN32
+	LARGE_INTEGER _start;
+#else
+	std::chrono::steady_clock::time_point _start;
+#endif
+};
+
+/**< The rough number of operations each measurement repeats for, so small pools are timed over several passes. */
+static const size_t TARGET_OPERATIONS = 1 << 22;
+
+/**< Keeps the optimizer from discarding component reads. */
+static volatile float benchmark_sink;
+
+/**
+*	Writes one measurement row.
+*/
+static void Report( const char *benchmark, size_t component_size, size_t num_components, size_t active_percent, size_t churn_percent, size_t operations, double nanoseconds )
+{
+	std::cout << benchmark << ',' << component_size << ',' << num_components << ',' << active_percent << ',' << churn_percent << ',' 
+		<< operations << ',' << ( operations ? nanoseconds / operations : 0.0 ) << std::endl;
+}
+
+/**
+*	Gets the number of passes needed to reach the target operation count.
+*/
+static size_t Passes( size_t operations_per_pass )
+{
+	return operations_per_pass < TARGET_OPERATIONS ? TARGET_OPERATIONS / operations_per_pass : 1;
+}
+
+/**
+*	Measures Create, SetActive and Delete throughput.
+*/
+template <size_t SIZE>
+static void BenchmarkCreateDelete( size_t num_components )
+{
+	typedef BenchmarkComponent<SIZE> Component;
+
+	const auto passes = Passes( num_components );
+	double create_time = 0.0, sleep_time = 0.0, wake_time = 0.0, delete_time = 0.0;
+
+	std::vector<ComponentReference<Component>> references;
+	references.reserve( num_components );
+
+	for ( size_t pass = 0; pass < passes; pass++ )
+	{
+		ComponentPool<Component> pool;
+		references.clear( );
+
+		BenchmarkTimer timer;
+		for ( size_t i = 0; i < num_components; i++ )
+			references.push_back( pool.Create( ) );
+		create_time += timer.Elapsed( );
+
+		// Changes are only applied by the late update, so it is part of each measurement
+		timer.Restart( );
+		for ( auto &reference : references )
+			pool.SetActive( reference, false );
+		pool.LateUpdate( );
+		sleep_time += timer.Elapsed( );
+
+		timer.Restart( );
+		for ( auto &reference : references )
+			pool.SetActive( reference, true );
+		pool.LateUpdate( );
+		wake_time += timer.Elapsed( );
+
+		timer.Restart( );
+		for ( auto &reference : references )
+			pool.Delete( reference );
+		pool.LateUpdate( );
+		delete_time += timer.Elapsed( );
+	}
+
+	const auto operations = passes * num_components;
+	Report( "create", SIZE, num_components, 100, 0, operations, create_time );
+	Report( "sleep", SIZE, num_components, 100, 0, operations, sleep_time );
+	Report( "wake", SIZE, num_components, 100, 0, operations, wake_time );
+	Report( "delete", SIZE, num_components, 100, 0, operations, delete_time );
+}
+
+/**
+*	Measures the cost of Update per active component with the given share of the pool awake.
+*/
+template <size_t SIZE>
+static void BenchmarkUpdate( size_t num_components, size_t active_percent )
+{
+	typedef BenchmarkComponent<SIZE> Component;
+
+	ComponentPool<Component> pool;
+	std::vector<ComponentReference<Component>> references;
+	references.reserve( num_components );
+	for ( size_t i = 0; i < num_components; i++ )
+		references.push_back( pool.Create( ) );
+
+	// Put a random selection of components to sleep
+	std::mt19937 random( 1 );
+	std::shuffle( references.begin( ), references.end( ), random );
+	const auto num_active = num_components * active_percent / 100;
+	for ( auto i = num_active; i < num_components; i++ )
+		pool.SetActive( references [ i ], false );
+	pool.LateUpdate( );
+
+	if ( !num_active )
+		return;
+
+	const auto passes = Passes( num_active );
+	BenchmarkTimer timer;
+	for ( size_t pass = 0; pass < passes; pass++ )
+		pool.Update( 0.016f );
+	const auto time = timer.Elapsed( );
+
+	benchmark_sink = references [ 0 ]->_value;
+	Report( "update", SIZE, num_components, active_percent, 0, passes * num_active, time );
+}
+
+/**
+*	Measures the cost of LateUpdate with the given share of the pool changing every frame.
+*
+*	Half of the churn deletes components (which are created again before the next frame) and half toggles their active state.
+*/
+template <size_t SIZE>
+static void BenchmarkLateUpdate( size_t num_components, size_t churn_percent )
+{
+	typedef BenchmarkComponent<SIZE> Component;
+
+	ComponentPool<Component> pool;
+	std::vector<ComponentReference<Component>> references;
+	references.reserve( num_components );
+	for ( size_t i = 0; i < num_components; i++ )
+		references.push_back( pool.Create( ) );
+
+	const auto num_changes = std::max<size_t>( 1, num_components * churn_percent / 100 );
+	const auto num_deletes = num_changes / 2;
+	const auto frames = Passes( num_changes );
+
+	std::mt19937 random( 2 );
+	double time = 0.0;
+
+	for ( size_t frame = 0; frame < frames; frame++ )
+	{
+		// Pick the components to change this frame
+		for ( size_t i = 0; i < num_changes; i++ )
+			std::swap( references [ i ], references [ i + random( ) % ( num_components - i ) ] );
+		for ( size_t i = 0; i < num_deletes; i++ )
+			pool.Delete( references [ i ] );
+		for ( size_t i = num_deletes; i < num_changes; i++ )
+			pool.SetActive( references [ i ], random( ) % 2 == 0 );
+
+		BenchmarkTimer timer;
+		pool.LateUpdate( );
+		time += timer.Elapsed( );
+
+		// Replace the deleted components
+		for ( size_t i = 0; i < num_deletes; i++ )
+			references [ i ] = pool.Create( );
+	}
+
+	Report( "late_update", SIZE, num_components, 100, churn_percent, frames * num_changes, time );
+}
+
+/**
+*	Measures the latency of dereferencing references and resolving handles in random order.
+*/
+template <size_t SIZE>
+static void BenchmarkGet( size_t num_components )
+{
+	typedef BenchmarkComponent<SIZE> Component;
+
+	ComponentPool<Component> pool;
+	std::vector<ComponentReference<Component>> references;
+	references.reserve( num_components );
+	for ( size_t i = 0; i < num_components; i++ )
+		references.push_back( pool.Create( ) );
+
+	// Access in random order so neither control blocks nor components are walked sequentially
+	std::mt19937 random( 3 );
+	std::shuffle( references.begin( ), references.end( ), random );
+
+	std::vector<ComponentHandle<Component>> handles;
+	handles.reserve( num_components );
+	for ( auto &reference : references )
+		handles.push_back( pool.GetHandle( reference ) );
+
+	const auto passes = Passes( num_components );
+	float sum = 0.0f;
+
+	BenchmarkTimer timer;
+	for ( size_t pass = 0; pass < passes; pass++ )
+	{
+		for ( auto &reference : references )
+			sum += reference.Get( )->_value;
+	}
+	const auto get_time = timer.Elapsed( );
+
+	timer.Restart( );
+	for ( size_t pass = 0; pass < passes; pass++ )
+	{
+		for ( auto &handle : handles )
+			sum += pool.Resolve( handle )->_value;
+	}
+	const auto resolve_time = timer.Elapsed( );
+
+	benchmark_sink = sum;
+	Report( "get", SIZE, num_components, 100, 0, passes * num_components, get_time );
+	Report( "resolve", SIZE, num_components, 100, 0, passes * num_components, resolve_time );
+}
+
+/**
+*	Runs every benchmark for a component size.
+*/
+template <size_t SIZE>
+static void BenchmarkComponentSize( )
+{
+	const size_t pool_sizes [ ] = { 1024, 65536, 524288 };
+	const size_t active_percents [ ] = { 100, 50, 10 };
+	const size_t churn_percents [ ] = { 1, 10, 50 };
+
+	for ( const auto num_components : pool_sizes )
+	{
+		BenchmarkCreateDelete<SIZE>( num_components );
+
+		for ( const auto active_percent : active_percents )
+			BenchmarkUpdate<SIZE>( num_components, active_percent );
+
+		for ( const auto churn_percent : churn_percents )
+			BenchmarkLateUpdate<SIZE>( num_components, churn_percent );
+
+		BenchmarkGet<SIZE>( num_components );
+	}
+}
+
+int _tmain(int, _TCHAR*[])
+{
+	std::cout << "benchmark,component_size,components,active_percent,churn_percent,operations,ns_per_op" << std::endl;
+
+	BenchmarkComponentSize<16>( );
+	BenchmarkComponentSize<64>( );
+	BenchmarkComponentSize<256>( );
+
+	return 0;
+}
\ No newline at end of file
@@ -25,15 +25,22 @@
 * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
-#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
 #include <stdexcept>
 
+#include "ChunkedArray.h"
 #include "ComponentReferenceControlBlock.h"
 
 /**
 *	A basic CompoentnReferenceControlBlock pool.
+*
+*	The pool grows a chunk at a time when it runs out of control blocks. Control blocks never move and are named by
+*	their index into the pool, which also links the free list.
 */
-template <size_t POOL_SIZE>
+template <size_t CHUNK_SIZE>
 class CRCBPool
 {
 public:
@@ -44,20 +51,27 @@ public:
 	typedef const ValueType* ConstPointer;
 	typedef ValueType& Reference;
 	typedef const ValueType& ConstReference;
+	typedef ValueType::IndexType IndexType;
 	typedef std::size_t SizeType;
 	typedef std::ptrdiff_t DifferenceType;
 
 #pragma endregion Allocator Typedefs
 
+	/**< Allocations and deallocations must be serialized by the owner of the pool. */
+	static const bool CONCURRENT = false;
+
 	/**
 	*	Constructs a CompoentnReferenceControlBlock pool.
+	*
+	*	@param resource the memory resource to allocate chunks of control blocks from, null for the global operator new
 	*/
-	inline explicit CRCBPool( )
+	inline explicit CRCBPool( ComponentMemoryResource *resource = nullptr )
+		: _pool_head( ValueType::NULL_INDEX )
+		, _num_allocated( 0 )
+		, _growable( true )
+		, _pool( resource )
 	{
-		// Setup pool stack
-		_pool_head = std::addressof( _pool [ 0 ] );
-		for ( SizeType i = 0; i < POOL_SIZE - 1; i++ )
-			_pool [ i ]._next = std::addressof( _pool [ i + 1 ] );
+
 	}
 
 	/**
@@ -76,26 +90,23 @@ public:
 #pragma region 
 
 	/**
-	*	Gets the address of the given reference.
+	*	Gets the control block at the given index.
+	*
+	*	Safe while another thread grows the pool for any index that was handed out before the call.
 	*/
-	inline Pointer Address( Reference r ) const { return std::addressof( r ); }
+	inline Reference operator[]( IndexType index ) const { return _pool.At( index ); }
 
 	/**
-	*	Gets the address of the given reference.
+	*	Gets the lookups into the pool for component references.
 	*/
-	inline ConstPointer Address( ConstReference r ) const { return std::addressof( r ); }
+	inline const ChunkedArrayView<ValueType>& GetView( ) const { return _pool; }
 
 	/**
-	*	Gets if the given pointer is valid (belongs to and is of expected alignment) for this allocator.
+	*	Gets if the given index names a control block of this pool.
 	*/
-	inline bool IsPointerValid( ConstPointer ptr ) const
+	inline bool IsIndexValid( IndexType index ) const
 	{
-		// Get the offset of the given pointer into the pool
-		const DifferenceType offset = ptr - std::addressof( _pool [ 0 ] );
-		
-		return !( !ptr || // Null pointers can never be valid
-			( offset < 0 || offset >= static_cast< DifferenceType >( POOL_SIZE ) ) || // Ensure the provided pointer actually belongs in this pool
-			( std::addressof( _pool [ offset ] ) != ptr ) ); // Ensure provided pointer has proper alignment in the pool
+		return index < Capacity( );
 	}
 
 #pragma endregion Address Helpers
@@ -104,20 +115,23 @@ public:
 
 	/**
 	*	Tries to allocate an object from the ObjectPool.
+	*
+	*	@returns the index of the allocated control block
 	*/
-	inline Pointer Allocate( SizeType num_objects )
+	inline IndexType Allocate( SizeType num_objects )
 	{
 		// Ensure the amount of requested objects is 1
 		if ( num_objects != 1 )
 			throw std::runtime_error( "ObjectPools only support allocating one object at a time." );
 
-		// Ensure we have items left in the pool to assign
-		if( !_pool_head )
-			throw std::runtime_error( "Tried to allocate an object from the ObjectPool but was empty." );
+		// Grow the pool if we have no items left to assign (may throw)
+		if( _pool_head == ValueType::NULL_INDEX )
+			Grow( );
 
 		// Pop an item from the ObjectPool
-		auto *item = _pool_head;
-		_pool_head = _pool_head->_next;
+		const auto item = _pool_head;
+		_pool_head = _pool [ item ]._next;
+		_num_allocated++;
 
 		// Return the popped item
 		return item;
@@ -126,19 +140,141 @@ public:
 	/**
 	*	Returns the given pool item back to the pool.
 	*/
-	void Deallocate( Pointer pool_item, SizeType num_objects )
+	void Deallocate( IndexType pool_item, SizeType num_objects )
 	{
 		// Ensure the amount of objects returned is only 1
 		if ( num_objects != 1 )
 			throw std::runtime_error( "ObjectPools only support deallocating one object at a time" );
 
-		// Ensure the given pool item pointer is valid
-		if ( !IsPointerValid( pool_item ) )
-			throw std::runtime_error( "Provided pointer to deallocate did not appear to be valid for the ObjectPool" );
+		// Ensure the given pool item index is valid
+		if ( !IsIndexValid( pool_item ) )
+			throw std::runtime_error( "Provided index to deallocate did not appear to be valid for the ObjectPool" );
 		
 		// Return item to pool
-		pool_item->_next = _pool_head;
+		_pool [ pool_item ]._next = _pool_head;
 		_pool_head = pool_item;
+		_num_allocated--;
+	}
+
+	/**
+	*	Allocates several objects from the ObjectPool in one go.
+	*
+	*	The pool grows once up front for the whole batch, so either every object is allocated or none are.
+	*
+	*	@param num_objects the number of control blocks to allocate
+	*	@param pool_items receives the indices of the allocated control blocks
+	*/
+	inline void Allocate( SizeType num_objects, IndexType *pool_items )
+	{
+		// Grow the pool until the free list can hand out the whole batch (may throw)
+		Reserve( _num_allocated + num_objects );
+
+		// Pop the items from the ObjectPool
+		auto item = _pool_head;
+		for ( SizeType i = 0; i < num_objects; i++ )
+		{
+			pool_items [ i ] = item;
+			item = _pool [ item ]._next;
+		}
+		_pool_head = item;
+		_num_allocated += num_objects;
+	}
+
+	/**
+	*	Returns several pool items back to the pool in one go.
+	*
+	*	@param pool_items the indices of the control blocks to return
+	*	@param num_objects the number of control blocks to return
+	*/
+	inline void Deallocate( const IndexType *pool_items, SizeType num_objects )
+	{
+		// Ensure every given pool item index is valid before touching the free list
+		for ( SizeType i = 0; i < num_objects; i++ )
+		{
+			if ( !IsIndexValid( pool_items [ i ] ) )
+				throw std::runtime_error( "Provided index to deallocate did not appear to be valid for the ObjectPool" );
+		}
+
+		// Return the items to the pool as one chain
+		for ( SizeType i = 0; i < num_objects; i++ )
+		{
+			_pool [ pool_items [ i ] ]._next = _pool_head;
+			_pool_head = pool_items [ i ];
+		}
+		_num_allocated -= num_objects;
+	}
+
+	/**
+	*	Rebuilds the free list after control blocks have been overwritten in place, such as by restoring a snapshot.
+	*
+	*	The lowest free indices are handed out first afterwards.
+	*
+	*	@param is_free the function telling if the control block at an index is free
+	*/
+	template <typename Predicate>
+	inline void RelinkFreeList( Predicate is_free )
+	{
+		_pool_head = ValueType::NULL_INDEX;
+		_num_allocated = 0;
+
+		for ( auto index = static_cast< IndexType >( Capacity( ) ); index-- > 0; )
+		{
+			if ( is_free( index ) )
+			{
+				_pool [ index ]._next = _pool_head;
+				_pool_head = index;
+			}
+			else
+			{
+				_num_allocated++;
+			}
+		}
+	}
+
+	/**
+	*	Appends a chunk of control blocks kept in storage owned by someone else. EG: A chunk of a mapped file.
+	*
+	*	@param chunk the storage for CHUNK_SIZE control blocks, aligned for the pool and outliving it
+	*	@param initialize true to set up fresh control blocks, false if the storage already holds the control blocks of a pool
+	*/
+	inline void AdoptChunk( ValueType *chunk, bool initialize )
+	{
+		// Control block indices must fit in an index, leaving out the null index
+		const auto first_index = _pool.Capacity( );
+		if ( ValueType::NULL_INDEX - first_index < CHUNK_SIZE )
+			throw std::runtime_error( "Control block pool cannot index any more control blocks." );
+
+		_pool.AdoptChunk( chunk );
+		if ( initialize )
+			InitializeChunk( chunk, first_index );
+	}
+
+	/**
+	*	Stops the pool from allocating chunks of its own once all of its storage has been adopted.
+	*/
+	inline void StopGrowing( )
+	{
+		_growable = false;
+	}
+
+	/**
+	*	Gets the first control block of the free list, for storing the pool state alongside adopted control blocks.
+	*/
+	inline IndexType GetFreeListHead( ) const
+	{
+		return _pool_head;
+	}
+
+	/**
+	*	Restores the free list of adopted control blocks that already hold the control blocks of a pool.
+	*
+	*	@param head the first control block of the free list
+	*	@param num_allocated the number of control blocks allocated
+	*/
+	inline void RestoreFreeList( IndexType head, SizeType num_allocated )
+	{
+		_pool_head = head;
+		_num_allocated = num_allocated;
 	}
 
 #pragma endregion Memory Allocation
@@ -148,11 +284,43 @@ public:
 	/**
 	*	Returns the maximum theoretically possible value of n, for which the call allocate(n) could succeed.
 	*
-	*	@returns the maximum number of objects we can allocate storage for at once
+	*	@returns the maximum number of objects we can allocate storage for at once, counting those the pool can still grow by
 	*/
 	inline SizeType MaxSize( ) const
 	{
-		return 1;
+		// Pools backed by fixed storage can only hand out the control blocks they have left
+		if ( !_growable )
+			return Capacity( ) - _num_allocated;
+
+		// Other pools can grow until control block indices run out, leaving out the null index
+		return ( ValueType::NULL_INDEX / CHUNK_SIZE ) * CHUNK_SIZE - _num_allocated;
+	}
+
+	/**
+	*	Gets the number of control blocks the pool currently has storage for.
+	*/
+	inline SizeType Capacity( ) const
+	{
+		return _pool.Capacity( );
+	}
+
+	/**
+	*	Gets the number of control blocks currently allocated from the pool.
+	*/
+	inline SizeType Size( ) const
+	{
+		return _num_allocated;
+	}
+
+	/**
+	*	Ensures the pool has storage for at least the given amount of control blocks.
+	*
+	*	@param capacity the desired capacity
+	*/
+	inline void Reserve( SizeType capacity )
+	{
+		while ( Capacity( ) < capacity )
+			Grow( );
 	}
 
 #pragma endregion Size
@@ -160,15 +328,14 @@ public:
 #pragma region 
 
 	/**
-	*	Constructs the item for the given pointer.
+	*	Constructs the item for the given index.
 	*/
-	template <typename... Args>
-	inline void Construct( Pointer p, Args... args ) const { new ( p ) ValueType( std::forward<Args>( args )... ); };
+	inline void Construct( IndexType p, IndexType component_index ) const { ( *this ) [ p ].Initialize( component_index ); };
 
 	/**
-	*	Destroys the item for the given pointer.
+	*	Destroys the item for the given index.
 	*/
-	inline void Destroy( Pointer p ) const { p->~ComponentReferenceControlBlock( ); }
+	inline void Destroy( IndexType p ) const { ( *this ) [ p ].Release( ); }
 
 #pragma endregion Construction/Destruction
 
@@ -195,9 +362,50 @@ public:
 
 private:
 
+	/**
+	*	Adds a new chunk of control blocks to the pool stack.
+	*/
+	inline void Grow( )
+	{
+		// Pools backed by fixed storage have all the control blocks they will ever have
+		if ( !_growable )
+			throw std::runtime_error( "Control block pool is backed by fixed storage and cannot grow." );
+
+		// Control block indices must fit in an index, leaving out the null index
+		const auto first_index = _pool.Capacity( );
+		if ( ValueType::NULL_INDEX - first_index < CHUNK_SIZE )
+			throw std::runtime_error( "Control block pool cannot index any more control blocks." );
+
+		// Allocate the new chunk (may throw)
+		auto *chunk = _pool.AddChunk( );
+		InitializeChunk( chunk, first_index );
+	}
+
+	/**
+	*	Sets the initial global state of a new chunk of control blocks and pushes them onto the pool stack.
+	*/
+	inline void InitializeChunk( ValueType *chunk, SizeType first_index )
+	{
+		// Control blocks own no resources so are never destructed
+		for ( SizeType i = 0; i < CHUNK_SIZE; i++ )
+			new ( std::addressof( chunk [ i ] ) ) ValueType( );
+
+		// Push the new chunk onto the pool stack
+		for ( SizeType i = 0; i < CHUNK_SIZE - 1; i++ )
+			chunk [ i ]._next = static_cast< IndexType >( first_index + i + 1 );
+		chunk [ CHUNK_SIZE - 1 ]._next = _pool_head;
+		_pool_head = static_cast< IndexType >( first_index );
+	}
+
 	/**< The ObjectPool pool head. */
-	ComponentReferenceControlBlock* _pool_head;
+	IndexType _pool_head;
+
+	/**< The number of control blocks allocated. */
+	SizeType _num_allocated;
+
+	/**< Whether the pool may allocate more chunks. */
+	bool _growable;
 
 	/**< The ObjectPool pool. */
-	std::array<ComponentReferenceControlBlock, POOL_SIZE> _pool;
+	ChunkedArray<ComponentReferenceControlBlock, CHUNK_SIZE> _pool;
 };
\ No newline at end of file
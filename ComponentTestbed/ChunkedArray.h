@@ -0,0 +1,337 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ComponentMemoryResource.h"
+
+/**
+*	Gets the base two logarithm of a power of two.
+*/
+template <size_t N>
+struct ChunkedArrayLog2
+{
+	static const size_t value = 1 + ChunkedArrayLog2<N / 2>::value;
+};
+
+template <>
+struct ChunkedArrayLog2<1>
+{
+	static const size_t value = 0;
+};
+
+/**
+*	Element lookups into a chunked array that do not depend on its chunk size.
+*
+*	Lookups go through a published copy of the chunk table, so they are safe while another thread grows the array. 
+*	Only elements whose index was handed over by the growing thread (EG: through a lock or an atomic) may be looked up.
+*/
+template <typename ValueType>
+class ChunkedArrayView
+{
+public:
+
+	/**
+	*	Gets the element at the given index.
+	*/
+	inline ValueType& At( size_t index ) const
+	{
+		return _published_chunks.load( std::memory_order_acquire ) [ index >> _chunk_shift ][ index & _chunk_mask ];
+	}
+
+protected:
+
+	/**
+	*	Constructs an empty view.
+	*
+	*	@param chunk_shift the base two logarithm of the chunk size
+	*/
+	inline explicit ChunkedArrayView( size_t chunk_shift )
+		: _published_chunks( nullptr )
+		, _chunk_shift( chunk_shift )
+		, _chunk_mask( ( static_cast< size_t >( 1 ) << chunk_shift ) - 1 )
+	{
+
+	}
+
+	/**
+	*	Views are only destroyed along with their chunked array.
+	*/
+	inline ~ChunkedArrayView( ) { }
+
+	/**
+	*	View copying is forbidden.
+	*/
+	ChunkedArrayView( ChunkedArrayView const& ) = delete;
+
+	/**
+	*	View copying is forbidden.
+	*/
+	ChunkedArrayView& operator=( ChunkedArrayView const& ) = delete;
+
+	/**< The current published chunk table. */
+	std::atomic<ValueType**> _published_chunks;
+
+	/**< The base two logarithm of the chunk size. */
+	const size_t _chunk_shift;
+
+	/**< The mask of the element offset into a chunk. */
+	const size_t _chunk_mask;
+};
+
+/**
+*	A growable array that allocates its storage in fixed size chunks.
+*
+*	Elements never move once their chunk has been allocated so pointers to elements stay valid as the array grows.
+*
+*	Chunks are uninitialized raw storage aligned to at least a cache line, taken from the memory resource of the array 
+*	or from the global operator new if it has none. The owner of the array is responsible for constructing elements 
+*	before use and destroying them before the array is destroyed.
+*
+*	Indexing the array directly must not race with growing it. ChunkedArrayView::At can be used for that instead.
+*/
+template <typename ValueType, size_t CHUNK_SIZE>
+class ChunkedArray : public ChunkedArrayView<ValueType>
+{
+	// Chunk indexing relies on cheap division
+	static_assert( CHUNK_SIZE > 0 && ( CHUNK_SIZE & ( CHUNK_SIZE - 1 ) ) == 0, "Chunk size must be a power of two." );
+
+public:
+
+	/**< The assumed size of a cache line. */
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	/**< The alignment of the first element of each chunk. */
+	static const size_t ALIGNMENT = std::alignment_of<ValueType>::value > CACHE_LINE_SIZE ? std::alignment_of<ValueType>::value : CACHE_LINE_SIZE;
+
+	/**
+	*	Constructs an empty chunked array.
+	*
+	*	@param resource the memory resource to allocate chunks from, null for the global operator new. Must outlive the array.
+	*/
+	inline explicit ChunkedArray( ComponentMemoryResource *resource = nullptr )
+		: ChunkedArrayView<ValueType>( ChunkedArrayLog2<CHUNK_SIZE>::value )
+		, _resource( resource )
+		, _published_capacity( 0 )
+	{
+
+	}
+
+	/**
+	*	Releases the storage of all chunks. No element destructors are run.
+	*/
+	inline ~ChunkedArray( )
+	{
+		for ( auto *allocation : _allocations )
+		{
+			if ( _resource )
+				_resource->Deallocate( allocation, CHUNK_BYTES, ALIGNMENT );
+			else
+				::operator delete( allocation );
+		}
+	}
+
+	/**
+	*	Chunked array copying is forbidden.
+	*/
+	ChunkedArray( ChunkedArray const& ) = delete;
+
+	/**
+	*	Chunked array copying is forbidden.
+	*/
+	ChunkedArray& operator=( ChunkedArray const& ) = delete;
+
+	/**
+	*	Gets the element at the given index.
+	*/
+	inline ValueType& operator[]( size_t index ) { return _chunks [ index / CHUNK_SIZE ][ index % CHUNK_SIZE ]; }
+
+	/**
+	*	Gets the element at the given index.
+	*/
+	inline const ValueType& operator[]( size_t index ) const { return _chunks [ index / CHUNK_SIZE ][ index % CHUNK_SIZE ]; }
+
+	/**
+	*	Gets the number of elements we currently have storage for.
+	*/
+	inline size_t Capacity( ) const { return _chunks.size( ) * CHUNK_SIZE; }
+
+	/**
+	*	Ensures we have storage for at least the given amount of elements.
+	*
+	*	@param capacity the desired capacity
+	*/
+	inline void Reserve( size_t capacity )
+	{
+		while ( Capacity( ) < capacity )
+			AddChunk( );
+	}
+
+	/**
+	*	Allocates a new uninitialized chunk at the end of the array.
+	*
+	*	@returns the first element of the new chunk
+	*/
+	inline ValueType* AddChunk( )
+	{
+		// Make room for the chunk in the lookup tables so the inserts below cannot throw
+		_chunks.reserve( _chunks.size( ) + 1 );
+		_allocations.reserve( _allocations.size( ) + 1 );
+		ReservePublishedChunks( _chunks.size( ) + 1 );
+
+		// Allocate the raw chunk storage, with enough slack to align it unless the resource aligns it (may throw)
+		auto *allocation = _resource ? _resource->Allocate( CHUNK_BYTES, ALIGNMENT ) : ::operator new( CHUNK_BYTES + ALIGNMENT - 1 );
+		const auto address = ( reinterpret_cast< std::uintptr_t >( allocation ) + ALIGNMENT - 1 ) & ~static_cast< std::uintptr_t >( ALIGNMENT - 1 );
+		auto *chunk = reinterpret_cast< ValueType* >( address );
+
+		// The array now owns the chunk
+		PublishChunk( chunk );
+		_allocations.push_back( allocation );
+		return chunk;
+	}
+
+	/**
+	*	Appends storage owned by someone else as a new chunk at the end of the array. EG: A chunk of a mapped file.
+	*
+	*	The storage must hold CHUNK_SIZE elements, be aligned to ALIGNMENT and outlive the array. It is not released by the array.
+	*
+	*	@param chunk the first element of the storage
+	*/
+	inline void AdoptChunk( ValueType *chunk )
+	{
+		// Make room for the chunk in the lookup tables so the inserts below cannot throw
+		_chunks.reserve( _chunks.size( ) + 1 );
+		ReservePublishedChunks( _chunks.size( ) + 1 );
+
+		PublishChunk( chunk );
+	}
+
+	/**
+	*	Calls the given function for each contiguous run of elements in the given index range.
+	*
+	*	@param begin the first index of the range
+	*	@param end one past the last index of the range
+	*	@param fn the function to call with a pointer to the first element of the run and the run length
+	*/
+	template <typename Function>
+	inline void ForEachSpan( size_t begin, size_t end, Function fn )
+	{
+		while ( begin < end )
+		{
+			// Clamp the run to the end of the chunk
+			const auto offset = begin % CHUNK_SIZE;
+			const auto count = std::min( CHUNK_SIZE - offset, end - begin );
+
+			fn( _chunks [ begin / CHUNK_SIZE ] + offset, count );
+
+			begin += count;
+		}
+	}
+
+	/**
+	*	Calls the given function for each contiguous run of elements in the given index range.
+	*
+	*	@param begin the first index of the range
+	*	@param end one past the last index of the range
+	*	@param fn the function to call with a pointer to the first element of the run and the run length
+	*/
+	template <typename Function>
+	inline void ForEachSpan( size_t begin, size_t end, Function fn ) const
+	{
+		while ( begin < end )
+		{
+			// Clamp the run to the end of the chunk
+			const auto offset = begin % CHUNK_SIZE;
+			const auto count = std::min( CHUNK_SIZE - offset, end - begin );
+
+			fn( static_cast< const ValueType* >( _chunks [ begin / CHUNK_SIZE ] + offset ), count );
+
+			begin += count;
+		}
+	}
+
+private:
+
+	/**
+	*	Appends a chunk that has room reserved for it in the lookup tables.
+	*/
+	inline void PublishChunk( ValueType *chunk )
+	{
+		// Publish the chunk for views before publishing the table itself
+		auto *published_chunks = _published_tables.back( ).get( );
+		published_chunks [ _chunks.size( ) ] = chunk;
+		this->_published_chunks.store( published_chunks, std::memory_order_release );
+
+		_chunks.push_back( chunk );
+	}
+
+	/**
+	*	Ensures the newest published chunk table has room for the given amount of chunks.
+	*
+	*	Tables are never modified once visible except to append chunks, and old tables are kept until the array 
+	*	is destroyed so views that loaded them can keep using them.
+	*/
+	inline void ReservePublishedChunks( size_t num_chunks )
+	{
+		if ( num_chunks <= _published_capacity )
+			return;
+
+		// Grow the table geometrically so the retired tables add up to at most the size of the newest one (may throw)
+		const auto capacity = std::max( num_chunks, _published_capacity * 2 );
+		_published_tables.reserve( _published_tables.size( ) + 1 );
+		std::unique_ptr<ValueType*[ ]> table( new ValueType*[ capacity ] );
+		std::copy( _chunks.begin( ), _chunks.end( ), table.get( ) );
+
+		_published_tables.push_back( std::move( table ) );
+		_published_capacity = capacity;
+	}
+
+	/**< The size of the storage of a chunk in bytes. */
+	static const size_t CHUNK_BYTES = CHUNK_SIZE * sizeof( ValueType );
+
+	/**< The chunks in allocation order. */
+	std::vector<ValueType*> _chunks;
+
+	/**< The unaligned allocations backing the chunks the array owns. */
+	std::vector<void*> _allocations;
+
+	/**< The memory resource chunks are allocated from, null for the global operator new. */
+	ComponentMemoryResource *_resource;
+
+	/**< The chunk tables published to views, newest last. */
+	std::vector<std::unique_ptr<ValueType*[ ]>> _published_tables;
+
+	/**< The number of chunks the newest published chunk table has room for. */
+	size_t _published_capacity;
+};
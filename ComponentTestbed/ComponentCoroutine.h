@@ -0,0 +1,895 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+*	Compile time switch for coroutine components.
+*
+*	Define COMPONENT_POOL_COROUTINES to 1 to compile ComponentCoroutinePool, which needs a compiler with C++20 coroutines.
+*	It defaults to on where the compiler reports coroutine support, so older compilers see an empty header.
+*/
+#ifndef COMPONENT_POOL_COROUTINES
+#if defined( __cpp_impl_coroutine ) && __cpp_impl_coroutine >= 201902L
+#define COMPONENT_POOL_COROUTINES 1
+#else
+#define COMPONENT_POOL_COROUTINES 0
+#endif
+#endif
+
+#if COMPONENT_POOL_COROUTINES
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "ComponentMemoryResource.h"
+#include "ComponentPool.h"
+
+/**
+*	Hands out coroutine frames from blocks of memory, keeping freed frames on a free list per size class for reuse.
+*
+*	Every coroutine of one function has a frame of the same size, so a pool of coroutine components settles on a few 
+*	size classes and stops allocating once it has as many frames as it has components. Frames allocated while a Scope 
+*	is open come from its arena. Not thread safe.
+*/
+class ComponentCoroutineFrameArena final
+{
+public:
+
+	/**< The granularity of frame sizes. */
+	static const size_t SIZE_CLASS = 64;
+
+	/**< The size of the blocks frames are cut from. */
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	/**
+	*	Makes coroutine frames allocated on this thread come from the given arena until the scope closes.
+	*/
+	class Scope final
+	{
+	public:
+
+		inline explicit Scope( ComponentCoroutineFrameArena &arena )
+			: _previous( Current( ) )
+		{
+			Current( ) = &arena;
+		}
+
+		inline ~Scope( )
+		{
+			Current( ) = _previous;
+		}
+
+		Scope( Scope const& ) = delete;
+		Scope& operator=( Scope const& ) = delete;
+
+	private:
+
+		/**< The arena of the enclosing scope. */
+		ComponentCoroutineFrameArena *_previous;
+	};
+
+	/**
+	*	Constructs an empty arena.
+	*
+	*	@param resource the memory resource to allocate blocks from, which must outlive the arena, null for the global operator new
+	*/
+	inline explicit ComponentCoroutineFrameArena( ComponentMemoryResource *resource = nullptr )
+		: _resource( resource )
+		, _cursor( nullptr )
+		, _remaining( 0 )
+	{
+
+	}
+
+	/**
+	*	Destroys the arena, freeing every block. Every frame must have been destroyed first.
+	*/
+	inline ~ComponentCoroutineFrameArena( )
+	{
+		for ( const auto &block : _blocks )
+		{
+			if ( _resource )
+				_resource->Deallocate( block.first, block.second, alignof( std::max_align_t ) );
+			else
+				::operator delete( block.first );
+		}
+	}
+
+	/**
+	*	Arena copying is forbidden.
+	*/
+	ComponentCoroutineFrameArena( ComponentCoroutineFrameArena const& ) = delete;
+
+	/**
+	*	Arena copying is forbidden.
+	*/
+	ComponentCoroutineFrameArena& operator=( ComponentCoroutineFrameArena const& ) = delete;
+
+	/**
+	*	Gets the arena of the innermost open scope on this thread, null if there is none.
+	*/
+	static inline ComponentCoroutineFrameArena*& Current( )
+	{
+		static thread_local ComponentCoroutineFrameArena *current = nullptr;
+		return current;
+	}
+
+	/**
+	*	Allocates a frame of the given size, reusing a freed frame of the same size class if there is one.
+	*/
+	inline void* Allocate( size_t size )
+	{
+		// Reuse a freed frame
+		const auto size_class = ( size + SIZE_CLASS - 1 ) / SIZE_CLASS;
+		if ( size_class < _free_lists.size( ) && _free_lists [ size_class ] )
+		{
+			auto *const frame = _free_lists [ size_class ];
+			_free_lists [ size_class ] = frame->_next;
+			return frame;
+		}
+
+		// Make sure the frame can be freed later (may throw)
+		if ( size_class >= _free_lists.size( ) )
+			_free_lists.resize( size_class + 1, nullptr );
+
+		// Frames too large for a block get a block of their own
+		const auto frame_size = size_class * SIZE_CLASS;
+		if ( frame_size > BLOCK_SIZE )
+			return AllocateBlock( frame_size );
+
+		// Cut the frame from the current block, starting a new one when it runs out (may throw)
+		if ( frame_size > _remaining )
+		{
+			_cursor = static_cast< unsigned char* >( AllocateBlock( BLOCK_SIZE ) );
+			_remaining = BLOCK_SIZE;
+		}
+
+		auto *const frame = _cursor;
+		_cursor += frame_size;
+		_remaining -= frame_size;
+		return frame;
+	}
+
+	/**
+	*	Returns a frame of the given size to its free list.
+	*/
+	inline void Deallocate( void *frame, size_t size ) _NOEXCEPT
+	{
+		const auto size_class = ( size + SIZE_CLASS - 1 ) / SIZE_CLASS;
+		auto *const free_frame = static_cast< FreeFrame* >( frame );
+		free_frame->_next = _free_lists [ size_class ];
+		_free_lists [ size_class ] = free_frame;
+	}
+
+private:
+
+	/**
+	*	A freed frame linked into its free list.
+	*/
+	struct FreeFrame
+	{
+		/**< The next freed frame of the size class. */
+		FreeFrame *_next;
+	};
+
+	/**
+	*	Allocates a block and keeps it to free with the arena.
+	*/
+	inline void* AllocateBlock( size_t size )
+	{
+		// Make sure the block can be freed later (may throw)
+		_blocks.reserve( _blocks.size( ) + 1 );
+
+		void *const block = _resource ? _resource->Allocate( size, alignof( std::max_align_t ) ) : ::operator new( size );
+		_blocks.push_back( std::make_pair( block, size ) );
+		return block;
+	}
+
+	/**< The memory resource blocks come from. */
+	ComponentMemoryResource *_resource;
+
+	/**< The blocks allocated and their sizes. */
+	std::vector<std::pair<void*, size_t>> _blocks;
+
+	/**< The freed frames of each size class. */
+	std::vector<FreeFrame*> _free_lists;
+
+	/**< The next free byte of the current block. */
+	unsigned char *_cursor;
+
+	/**< The number of bytes left in the current block. */
+	size_t _remaining;
+};
+
+/**
+*	Counts how often it was signalled, waking the coroutine components waiting on it. Thread safe.
+*/
+class ComponentCoroutineEvent final
+{
+public:
+
+	inline ComponentCoroutineEvent( )
+		: _num_signals( 0 )
+	{
+
+	}
+
+	/**
+	*	Event copying is forbidden.
+	*/
+	ComponentCoroutineEvent( ComponentCoroutineEvent const& ) = delete;
+
+	/**
+	*	Event copying is forbidden.
+	*/
+	ComponentCoroutineEvent& operator=( ComponentCoroutineEvent const& ) = delete;
+
+	/**
+	*	Wakes every component waiting on the event by the next late update of its pool.
+	*/
+	inline void Signal( ) { _num_signals.fetch_add( 1 ); }
+
+	/**
+	*	Gets the number of times the event was signalled.
+	*/
+	inline uint64_t GetNumSignals( ) const { return _num_signals.load( ); }
+
+private:
+
+	/**< The number of times the event was signalled. */
+	std::atomic<uint64_t> _num_signals;
+};
+
+/**
+*	What a coroutine component can wait for, to be used as co_await ComponentCoroutine::NextFrame( ) and so on.
+*/
+struct ComponentCoroutine
+{
+	/**< How a coroutine component is waiting. */
+	enum WaitType
+	{
+		WAIT_NONE,
+		WAIT_NEXT_FRAME,
+		WAIT_FRAMES,
+		WAIT_EVENT
+	};
+
+	/**
+	*	A wait for the coroutine to give to co_await.
+	*/
+	struct Wait
+	{
+		/**< How the coroutine waits. */
+		WaitType _type;
+
+		/**< The number of frames to sleep for. */
+		uint32_t _num_frames;
+
+		/**< The event to wait on. */
+		ComponentCoroutineEvent *_event;
+	};
+
+	/**
+	*	Gets the component and the time since the coroutine last waited without waiting.
+	*/
+	static inline Wait Current( ) { return Wait { WAIT_NONE, 0, nullptr }; }
+
+	/**
+	*	Waits for the next frame. The component stays active.
+	*/
+	static inline Wait NextFrame( ) { return Wait { WAIT_NEXT_FRAME, 0, nullptr }; }
+
+	/**
+	*	Puts the component to sleep and resumes it after the given number of frames (see ComponentPool::WakeAfter).
+	*/
+	static inline Wait Sleep( uint32_t num_frames ) { return Wait { num_frames == 0 ? WAIT_NEXT_FRAME : WAIT_FRAMES, num_frames, nullptr }; }
+
+	/**
+	*	Puts the component to sleep and resumes it the frame after the event is next signalled.
+	*/
+	static inline Wait WaitFor( ComponentCoroutineEvent &event ) { return Wait { WAIT_EVENT, 0, &event }; }
+};
+
+/**
+*	What a coroutine component gets back from co_await.
+*
+*	Components move around their pool while the coroutine is suspended, so the component pointer is only valid until 
+*	the coroutine next waits. Coroutines must not keep pointers or references to their component across a co_await.
+*/
+template <typename ComponentType>
+struct ComponentCoroutineResume
+{
+	/**< The component of the coroutine. */
+	ComponentType *_component;
+
+	/**< The time since the coroutine last waited, or since its component was created. */
+	float _dt;
+};
+
+/**
+*	The return type of the coroutine of a coroutine component.
+*/
+template <typename ComponentType>
+class ComponentCoroutineTask final
+{
+public:
+
+	/**
+	*	The state a coroutine shares with the pool that resumes it.
+	*/
+	struct promise_type
+	{
+		inline promise_type( )
+			: _component( nullptr )
+			, _dt( 0 )
+		{
+			_wait = ComponentCoroutine::NextFrame( );
+		}
+
+		/**
+		*	Awaits a wait, recording it for the pool.
+		*/
+		struct Awaiter
+		{
+			inline bool await_ready( ) const _NOEXCEPT { return _promise->_wait._type == ComponentCoroutine::WAIT_NONE; }
+
+			inline void await_suspend( std::coroutine_handle<> ) const _NOEXCEPT { }
+
+			inline ComponentCoroutineResume<ComponentType> await_resume( ) const _NOEXCEPT
+			{
+				return ComponentCoroutineResume<ComponentType> { _promise->_component, _promise->_dt };
+			}
+
+			/**< The promise of the waiting coroutine. */
+			promise_type *_promise;
+		};
+
+		/**
+		*	Allocates the frame from the arena of the open scope, or the global operator new if there is none.
+		*
+		*	The arena is kept in front of the frame, so the frame goes back where it came from.
+		*/
+		static inline void* operator new( size_t size )
+		{
+			auto *const arena = ComponentCoroutineFrameArena::Current( );
+			auto *const block = static_cast< unsigned char* >( arena ? arena->Allocate( size + FRAME_HEADER_SIZE ) : ::operator new( size + FRAME_HEADER_SIZE ) );
+			*reinterpret_cast< ComponentCoroutineFrameArena** >( block ) = arena;
+			return block + FRAME_HEADER_SIZE;
+		}
+
+		/**
+		*	Returns the frame to the arena it came from.
+		*/
+		static inline void operator delete( void *frame, size_t size ) _NOEXCEPT
+		{
+			auto *const block = static_cast< unsigned char* >( frame ) - FRAME_HEADER_SIZE;
+			auto *const arena = *reinterpret_cast< ComponentCoroutineFrameArena** >( block );
+			if ( arena )
+				arena->Deallocate( block, size + FRAME_HEADER_SIZE );
+			else
+				::operator delete( block );
+		}
+
+		inline ComponentCoroutineTask get_return_object( ) { return ComponentCoroutineTask( std::coroutine_handle<promise_type>::from_promise( *this ) ); }
+
+		/**< Coroutines first run when their component is first updated. */
+		inline std::suspend_always initial_suspend( ) const _NOEXCEPT { return std::suspend_always( ); }
+
+		/**< Finished coroutines stay suspended until their component is deleted. */
+		inline std::suspend_always final_suspend( ) const _NOEXCEPT { return std::suspend_always( ); }
+
+		inline void return_void( ) { }
+
+		inline void unhandled_exception( ) { _exception = std::current_exception( ); }
+
+		inline Awaiter await_transform( const ComponentCoroutine::Wait &wait )
+		{
+			_wait = wait;
+			return Awaiter { this };
+		}
+
+		/**< The current address of the component, kept up to date by the pool before every resume. */
+		ComponentType *_component;
+
+		/**< The time since the coroutine last waited. */
+		float _dt;
+
+		/**< What the coroutine is waiting for. */
+		ComponentCoroutine::Wait _wait;
+
+		/**< The exception the coroutine finished with, if any. */
+		std::exception_ptr _exception;
+	};
+
+	/**
+	*	Constructs a task without a coroutine.
+	*/
+	inline ComponentCoroutineTask( )
+	{
+
+	}
+
+	/**
+	*	Destroys the coroutine of the task.
+	*/
+	inline ~ComponentCoroutineTask( )
+	{
+		if ( _coroutine )
+			_coroutine.destroy( );
+	}
+
+	/**
+	*	Move constructor for tasks.
+	*/
+	inline ComponentCoroutineTask( ComponentCoroutineTask &&other ) _NOEXCEPT
+		: _coroutine( std::exchange( other._coroutine, nullptr ) )
+	{
+
+	}
+
+	/**
+	*	Move assignment for tasks.
+	*/
+	inline ComponentCoroutineTask& operator=( ComponentCoroutineTask &&other ) _NOEXCEPT
+	{
+		std::swap( _coroutine, other._coroutine );
+		return *this;
+	}
+
+	ComponentCoroutineTask( ComponentCoroutineTask const& ) = delete;
+	ComponentCoroutineTask& operator=( ComponentCoroutineTask const& ) = delete;
+
+	/**
+	*	Gets the coroutine of the task, null if it has none.
+	*/
+	inline std::coroutine_handle<promise_type> GetCoroutine( ) const { return _coroutine; }
+
+private:
+
+	/**< Frames keep the arena they came from in front of them, padded to keep the frame aligned. */
+	static const size_t FRAME_HEADER_SIZE = alignof( std::max_align_t );
+
+	inline explicit ComponentCoroutineTask( std::coroutine_handle<promise_type> coroutine )
+		: _coroutine( coroutine )
+	{
+
+	}
+
+	/**< The coroutine of the task. */
+	std::coroutine_handle<promise_type> _coroutine;
+};
+
+template <typename ComponentType, typename Traits>
+class ComponentCoroutinePool;
+
+/**
+*	The component a coroutine component pool keeps, holding the component and its coroutine.
+*/
+template <typename ComponentType, typename Traits>
+class ComponentCoroutineHost final
+{
+	/**< Allow the coroutine pool to resume the coroutine. */
+	friend class ComponentCoroutinePool<ComponentType, Traits>;
+
+public:
+
+	/**
+	*	Constructs the component and starts its coroutine, which first runs when the component is first updated.
+	*
+	*	@param owner the coroutine pool of the component
+	*	@param args the constructor arguments for the component
+	*/
+	template <typename... Args>
+	inline explicit ComponentCoroutineHost( ComponentCoroutinePool<ComponentType, Traits> *owner, Args &&... args )
+		: _owner( owner )
+		, _component( std::forward<Args>( args )... )
+		, _task( ComponentType::Run( ) )
+		, _last_resume_time( owner->_time )
+		, _num_waits( 0 )
+	{
+
+	}
+
+	/**
+	*	Move constructor for hosts, taking the coroutine along.
+	*/
+	inline ComponentCoroutineHost( ComponentCoroutineHost &&other ) _NOEXCEPT
+		: _owner( other._owner )
+		, _component( std::move( other._component ) )
+		, _task( std::move( other._task ) )
+		, _self( other._self )
+		, _last_resume_time( other._last_resume_time )
+		, _num_waits( other._num_waits )
+	{
+
+	}
+
+	/**
+	*	Move assignment for hosts, taking the coroutine along.
+	*/
+	inline ComponentCoroutineHost& operator=( ComponentCoroutineHost &&other ) _NOEXCEPT
+	{
+		_owner = other._owner;
+		_component = std::move( other._component );
+		_task = std::move( other._task );
+		_self = other._self;
+		_last_resume_time = other._last_resume_time;
+		_num_waits = other._num_waits;
+		return *this;
+	}
+
+	/**
+	*	Resumes the coroutine of the component.
+	*/
+	inline void Update( const float ) { _owner->Resume( *this ); }
+
+	/**
+	*	Gets the component.
+	*/
+	inline ComponentType& Get( ) { return _component; }
+
+	/**
+	*	Gets the component.
+	*/
+	inline const ComponentType& Get( ) const { return _component; }
+
+private:
+
+	/**< The coroutine pool of the component. */
+	ComponentCoroutinePool<ComponentType, Traits> *_owner;
+
+	/**< The component. */
+	ComponentType _component;
+
+	/**< The coroutine of the component. */
+	ComponentCoroutineTask<ComponentType> _task;
+
+	/**< The reference to this host, for the changes the coroutine asks of the pool. */
+	ComponentReference<ComponentCoroutineHost> _self;
+
+	/**< The pool time the coroutine was last resumed, or the component created at. */
+	double _last_resume_time;
+
+	/**< The number of times the coroutine waited, telling stale event waits apart. */
+	uint64_t _num_waits;
+};
+
+/**
+*	Keeps components whose behaviour is a coroutine, resuming each coroutine only once what it waits for is ready.
+*
+*	Component types provide static ComponentCoroutineTask<ComponentType> Run( ), which is started when a component is 
+*	created and first runs when it is first updated. Coroutines have no this pointer to hold on to, as components move 
+*	while they are suspended, and get at their component through what co_await gives back instead:
+*
+*	static ComponentCoroutineTask<Door> Run( )
+*	{
+*		for ( ;; )
+*		{
+*			auto resume = co_await ComponentCoroutine::WaitFor( door_bell );
+*			resume._component->Open( );
+*			co_await ComponentCoroutine::Sleep( 120 );
+*		}
+*	}
+*
+*	Coroutines waiting for the next frame stay in the active block. Coroutines that sleep or wait on an event are put 
+*	to sleep with WakeAfter and SetActive, so the swaps of the late update move them out of the active block and updates 
+*	never visit them. Waits end when the component is next updated, so a component woken early resumes early. Event 
+*	waits are checked by LateUpdate, and signals given before a coroutine suspends are only seen by later waits. 
+*	Coroutines that return have their component deleted by the end of the frame. Exceptions thrown by a coroutine 
+*	finish it and are passed on by Update.
+*
+*	Frames come from an arena the pool owns rather than the heap. Update must not run in parallel, and the pool must 
+*	otherwise be used like a ComponentPool, which GetPool gives access to. Components must be created through Create 
+*	or CreateDeferred of the coroutine pool, creating them through GetPool is not supported.
+*/
+template <typename ComponentType, typename Traits = ComponentPoolTraits<ComponentType>>
+class ComponentCoroutinePool final
+{
+	/**< Allow hosts to reach the pool time and ask for changes. */
+	friend class ComponentCoroutineHost<ComponentType, Traits>;
+
+public:
+
+	/**< The component the pool keeps for each coroutine component. */
+	typedef ComponentCoroutineHost<ComponentType, Traits> HostType;
+
+	/**< The component pool the hosts live in. */
+	typedef ComponentPool<HostType, Traits> PoolType;
+
+	/**
+	*	Constructs an empty coroutine pool.
+	*
+	*	@param max_components the maximum amount of components the pool should allow for
+	*	@param resource the memory resource to allocate chunks and coroutine frames from, null for the global operator new
+	*/
+	inline explicit ComponentCoroutinePool( size_t max_components = std::numeric_limits<size_t>::max( ), ComponentMemoryResource *resource = nullptr )
+		: _frames( resource )
+		, _pool( max_components, resource )
+		, _time( 0 )
+	{
+
+	}
+
+	/**
+	*	Coroutine pool copying is forbidden.
+	*/
+	ComponentCoroutinePool( ComponentCoroutinePool const& ) = delete;
+
+	/**
+	*	Coroutine pool copying is forbidden.
+	*/
+	ComponentCoroutinePool& operator=( ComponentCoroutinePool const& ) = delete;
+
+	/**
+	*	Gets the component pool the hosts live in.
+	*/
+	inline PoolType& GetPool( ) { return _pool; }
+
+	/**
+	*	Creates a new active component and starts its coroutine.
+	*
+	*	@param args the constructor arguments for the component
+	*	@returns the component reference for the host of the component
+	*/
+	template <typename... Args>
+	inline ComponentReference<HostType> Create( Args &&... args )
+	{
+		// Start the coroutine in a frame from the arena (may throw)
+		ComponentCoroutineFrameArena::Scope scope( _frames );
+		auto component = _pool.Create( this, std::forward<Args>( args )... );
+		component.Get( )->_self = component;
+
+		return component;
+	}
+
+	/**
+	*	Creates a new active component at the end of the update tick, starting its coroutine then. Thread safe.
+	*
+	*	@param args the constructor arguments for the component
+	*	@returns the component reference for the host of the component, which cannot be dereferenced until it is created
+	*/
+	template <typename... Args>
+	inline ComponentReference<HostType> CreateDeferred( Args &&... args )
+	{
+		// Make sure the host can be bound once it is created (may throw)
+		std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+		_deferred_creates.reserve( _deferred_creates.size( ) + 1 );
+
+		auto component = _pool.CreateDeferred( this, std::forward<Args>( args )... );
+		_deferred_creates.push_back( component );
+
+		return component;
+	}
+
+	/**
+	*	Updates the pool, resuming the coroutines of the active components.
+	*
+	*	@param dt the time since the last frame
+	*/
+	inline void Update( const float dt )
+	{
+		_time += dt;
+
+		// Make sure every coroutine can ask for a change (may throw)
+		_requests.reserve( _pool.Capacity( ) );
+
+		// Apply the changes the coroutines asked for even if one of them threw
+		try
+		{
+			_pool.Update( dt );
+		}
+		catch ( ... )
+		{
+			ApplyRequests( );
+			throw;
+		}
+
+		ApplyRequests( );
+	}
+
+	/**
+	*	Wakes the components whose events were signalled and applies the pending changes of the pool.
+	*/
+	inline void LateUpdate( )
+	{
+		// Drop waits of deleted components and of coroutines that have moved on, and wake those whose event was signalled
+		size_t num_waits = 0;
+		for ( auto &wait : _waits )
+		{
+			const auto &component = wait._component;
+			if ( !component.IsValid( ) || component.Get( )->_num_waits != wait._num_waits )
+				continue;
+
+			if ( wait._event->GetNumSignals( ) != wait._num_signals )
+			{
+				_pool.WakeAfter( component, 0 );
+				continue;
+			}
+
+			_waits [ num_waits++ ] = wait;
+		}
+		_waits.resize( num_waits );
+
+		// Start the coroutines of deferred creates in frames from the arena, binding the hosts even if a create threw
+		ComponentCoroutineFrameArena::Scope scope( _frames );
+		try
+		{
+			_pool.LateUpdate( );
+		}
+		catch ( ... )
+		{
+			BindDeferredCreates( );
+			throw;
+		}
+
+		BindDeferredCreates( );
+	}
+
+private:
+
+	/**
+	*	A change a coroutine asked of the pool while it was running.
+	*/
+	struct Request
+	{
+		/**< The component of the coroutine. */
+		ComponentReference<HostType> _component;
+
+		/**< What the coroutine waits for. */
+		ComponentCoroutine::Wait _wait;
+
+		/**< The number of times the event waited on had been signalled when the coroutine suspended. */
+		uint64_t _num_signals;
+
+		/**< Whether the coroutine has returned. */
+		bool _finished;
+	};
+
+	/**
+	*	A component waiting on an event.
+	*/
+	struct EventWait
+	{
+		/**< The waiting component. */
+		ComponentReference<HostType> _component;
+
+		/**< The event waited on. */
+		ComponentCoroutineEvent *_event;
+
+		/**< The number of times the event had been signalled when the wait began. */
+		uint64_t _num_signals;
+
+		/**< The wait count of the coroutine when the wait began. */
+		uint64_t _num_waits;
+	};
+
+	/**
+	*	Resumes the coroutine of a host and records what it waits for next.
+	*/
+	inline void Resume( HostType &host )
+	{
+		const auto coroutine = host._task.GetCoroutine( );
+		if ( !coroutine || coroutine.done( ) )
+			return;
+
+		// Point the coroutine at where its component is now
+		auto &promise = coroutine.promise( );
+		promise._component = &host._component;
+		promise._dt = static_cast< float >( _time - host._last_resume_time );
+		host._last_resume_time = _time;
+
+		coroutine.resume( );
+
+		// Components waiting for the next frame stay as they are
+		if ( !coroutine.done( ) && promise._wait._type == ComponentCoroutine::WAIT_NEXT_FRAME )
+			return;
+
+		// Count signals from here, so signals given by components updated later in the frame end the wait
+		const auto num_signals = !coroutine.done( ) && promise._wait._type == ComponentCoroutine::WAIT_EVENT ? promise._wait._event->GetNumSignals( ) : 0;
+
+		host._num_waits++;
+		_requests.push_back( Request { host._self, promise._wait, num_signals, coroutine.done( ) } );
+
+		// Pass on what the coroutine finished with
+		if ( promise._exception )
+			std::rethrow_exception( std::exchange( promise._exception, nullptr ) );
+	}
+
+	/**
+	*	Points the hosts made by CreateDeferred at their references, skipping creates that failed or were deleted.
+	*/
+	inline void BindDeferredCreates( )
+	{
+		std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+		for ( const auto &component : _deferred_creates )
+		{
+			if ( component.IsValid( ) )
+				component.Get( )->_self = component;
+		}
+		_deferred_creates.clear( );
+	}
+
+	/**
+	*	Applies the changes the coroutines asked for during the update.
+	*/
+	inline void ApplyRequests( )
+	{
+		// Make sure every request can start an event wait (may throw)
+		_waits.reserve( _waits.size( ) + _requests.size( ) );
+
+		for ( const auto &request : _requests )
+		{
+			if ( request._finished )
+			{
+				_pool.Delete( request._component );
+				continue;
+			}
+
+			if ( request._wait._type == ComponentCoroutine::WAIT_FRAMES )
+			{
+				_pool.WakeAfter( request._component, request._wait._num_frames );
+				continue;
+			}
+
+			// Sleep until the event wakes the component
+			_waits.push_back( EventWait { request._component, request._wait._event, request._num_signals, request._component.Get( )->_num_waits } );
+			_pool.SetActive( request._component, false );
+		}
+
+		_requests.clear( );
+	}
+
+	/**< The arena coroutine frames come from, which outlives the components. */
+	ComponentCoroutineFrameArena _frames;
+
+	/**< The pool the hosts live in. */
+	PoolType _pool;
+
+	/**< The sum of the time steps given to updates. */
+	double _time;
+
+	/**< The changes the coroutines asked for during the current update. */
+	std::vector<Request> _requests;
+
+	/**< The components waiting on events. */
+	std::vector<EventWait> _waits;
+
+	/**< The references of components created with CreateDeferred that have no reference to themselves yet. */
+	std::vector<ComponentReference<HostType>> _deferred_creates;
+
+	/**< Guards the deferred creates against concurrent CreateDeferred calls. */
+	std::mutex _deferred_creates_mutex;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+*	Identifies an entity of a component world.
+*
+*	An entity is the index of its slot in the world plus the generation of the slot when the entity was created.
+*	Slots are reused once their entity is destroyed, so entities kept across their destruction compare unequal
+*	to the entity that reuses the slot.
+*/
+class ComponentEntity final
+{
+	/**< Allow component worlds to make entities. */
+	friend class ComponentWorld;
+
+public:
+
+	/**
+	*	Constructs a null entity.
+	*/
+	inline ComponentEntity( )
+		: _index( NULL_INDEX )
+		, _generation( 0 )
+	{
+
+	}
+
+	/**
+	*	Constructs a null entity.
+	*/
+	inline ComponentEntity( std::nullptr_t )
+		: ComponentEntity( )
+	{
+
+	}
+
+	/**
+	*	Checks if this is the null entity.
+	*/
+	inline bool IsNull( ) const { return _index == NULL_INDEX; }
+
+	/**
+	*	Gets the index of the entity's slot in its world.
+	*/
+	inline uint32_t GetIndex( ) const { return _index; }
+
+	/**
+	*	Gets the generation of the entity in its slot.
+	*/
+	inline uint32_t GetGeneration( ) const { return _generation; }
+
+	/**
+	*	Checks if two entities are the same entity.
+	*/
+	inline bool operator==( const ComponentEntity &entity ) const { return _index == entity._index && _generation == entity._generation; }
+
+	/**
+	*	Checks if two entities are different entities.
+	*/
+	inline bool operator!=( const ComponentEntity &entity ) const { return !operator==( entity ); }
+
+	/**< The index of null entities, no world ever has this many slots. */
+	static const uint32_t NULL_INDEX = UINT32_MAX;
+
+private:
+
+	/**
+	*	Constructs an entity.
+	*
+	*	@param index the index of the entity's slot
+	*	@param generation the generation of the entity in its slot
+	*/
+	inline ComponentEntity( uint32_t index, uint32_t generation )
+		: _index( index )
+		, _generation( generation )
+	{
+
+	}
+
+	/**< The index of the entity's slot. */
+	uint32_t _index;
+
+	/**< The generation of the entity in its slot. */
+	uint32_t _generation;
+};
+
+namespace std
+{
+	/**
+	*	Specializes std::hash so that entities can key hashed containers.
+	*/
+	template <>
+	struct hash < ComponentEntity >
+	{
+		size_t operator( )( const ComponentEntity &entity ) const
+		{
+			return std::hash<uint64_t>( )( static_cast<uint64_t>( entity.GetGeneration( ) ) << 32 | entity.GetIndex( ) );
+		}
+	};
+}
\ No newline at end of file
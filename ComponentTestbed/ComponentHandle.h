@@ -0,0 +1,132 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+*	Compact generational handles for components.
+*
+*	A handle is the index of the component's control block plus the generation (garbage tag) of the control block
+*	when the handle was made. Handles are resolved through the dense control block array of the component pool that 
+*	made them (see ComponentPool::Resolve), or turned back into references to change their component (see 
+*	ComponentPool::GetReference). Handles only identify components within the pool that made them. Generations are 
+*	32 bit, so a handle kept across 2^32 reuses of the same slot may resolve to a newer component.
+*/
+template <typename ComponentType>
+class ComponentHandle final
+{
+	/**< Allow component pools to make and resolve handles. */
+	template <typename T, typename Traits>
+	friend class ComponentPool;
+
+public:
+
+	/**
+	*	Constructs a null component handle.
+	*/
+	inline ComponentHandle( )
+		: _slot( NULL_SLOT )
+		, _generation( 0 )
+	{
+
+	}
+
+	/**
+	*	Constructs a null component handle.
+	*/
+	inline ComponentHandle( std::nullptr_t )
+		: ComponentHandle( )
+	{
+
+	}
+
+	/**
+	*	Checks if this is the null handle.
+	*/
+	inline bool IsNull( ) const { return _slot == NULL_SLOT; }
+
+	/**
+	*	Gets the handle slot (control block index) of the component.
+	*/
+	inline uint32_t GetSlot( ) const { return _slot; }
+
+	/**
+	*	Gets the generation of the component in its handle slot.
+	*/
+	inline uint32_t GetGeneration( ) const { return _generation; }
+
+	/**
+	*	Checks if two handles identify the same component.
+	*/
+	inline bool operator==( const ComponentHandle &handle ) const { return _slot == handle._slot && _generation == handle._generation; }
+
+	/**
+	*	Checks if two handles identify different components.
+	*/
+	inline bool operator!=( const ComponentHandle &handle ) const { return !operator==( handle ); }
+
+private:
+
+	/**
+	*	Constructs a component handle.
+	*
+	*	@param slot the handle slot of the component
+	*	@param generation the generation of the component in its handle slot
+	*/
+	inline ComponentHandle( uint32_t slot, uint32_t generation )
+		: _slot( slot )
+		, _generation( generation )
+	{
+
+	}
+
+	/**< The slot of null handles, no pool ever has this many slots. */
+	static const uint32_t NULL_SLOT = UINT32_MAX;
+
+	/**< The handle slot of the component. */
+	uint32_t _slot;
+
+	/**< The generation of the component in its handle slot. */
+	uint32_t _generation;
+};
+
+namespace std
+{
+	/**
+	*	Specializes std::hash so that component handles can key hashed containers.
+	*/
+	template <class ComponentType>
+	struct hash < ComponentHandle<ComponentType> >
+	{
+		size_t operator( )( const ComponentHandle<ComponentType> &handle ) const
+		{
+			return std::hash<uint64_t>( )( static_cast<uint64_t>( handle.GetGeneration( ) ) << 32 | handle.GetSlot( ) );
+		}
+	};
+}
@@ -0,0 +1,669 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ComponentHandle.h"
+#include "ComponentPool.h"
+#include "ComponentPoolListener.h"
+
+/**
+*	Indexes the components of a pool by a key taken from each component. EG: The owner of the component.
+*
+*	The index follows the pool through its lifecycle events, so it must be set as the listener of the pool (see 
+*	ComponentPool::SetListener) and is brought up to date by every LateUpdate. Events are passed on to the next 
+*	listener, so several indices can follow one pool. Components whose keys change have to be refreshed, which 
+*	RefreshDirty does for the changed components of pools that track changes. Indices set up over a pool that already 
+*	holds components, or after the pool is restored from a snapshot, are filled in by Rebuild.
+*
+*	Lookups give back handles rather than component indices, as handles stay valid while the pool moves components. 
+*	The handles of one key lie next to each other and can be resolved in bulk with ComponentPool::Resolve. Sleeping 
+*	components are indexed as well. Needs storage that keeps whole components (see ComponentStorage), and keys must 
+*	be default constructible, copyable, comparable with == and hashable by the given hash.
+*/
+template <typename ComponentType, typename KeyType, typename Traits = ComponentPoolTraits<ComponentType>, typename Hash = std::hash<KeyType>>
+class ComponentKeyIndex final : public ComponentPoolListener<ComponentType>
+{
+public:
+
+	/**< Gives the key of a component. */
+	typedef std::function<KeyType( const ComponentType& )> KeyFunction;
+
+	/**
+	*	Constructs an empty index.
+	*
+	*	@param pool the pool to index, which must outlive the index
+	*	@param key the function giving the key of a component
+	*	@param next the listener to pass events on to, null if there is none
+	*/
+	inline ComponentKeyIndex( const ComponentPool<ComponentType, Traits> &pool, KeyFunction key, ComponentPoolListener<ComponentType> *next = nullptr )
+		: _pool( pool )
+		, _key( std::move( key ) )
+		, _next( next )
+		, _size( 0 )
+	{
+
+	}
+
+	/**
+	*	Gets the components with the given key.
+	*
+	*	The handles are invalidated by the next change to the index.
+	*
+	*	@param key the key to look up
+	*	@param count receives the number of components with the key
+	*	@returns the handles of the components, null if there are none
+	*/
+	inline const ComponentHandle<ComponentType>* Find( const KeyType &key, size_t &count ) const
+	{
+		const auto bucket = _buckets.find( key );
+		if ( bucket == _buckets.end( ) )
+		{
+			count = 0;
+			return nullptr;
+		}
+
+		count = bucket->second.size( );
+		return bucket->second.data( );
+	}
+
+	/**
+	*	Gets the number of components in the index.
+	*/
+	inline size_t Size( ) const { return _size; }
+
+	/**
+	*	Takes the key of a component again after it changed. Components that are gone are dropped from the index.
+	*/
+	inline void Refresh( const ComponentHandle<ComponentType> &handle )
+	{
+		const auto *const component = _pool.Resolve( handle );
+		if ( component )
+			Insert( handle, *component );
+		else
+			Remove( handle );
+	}
+
+	/**
+	*	Takes the keys of the active components marked as changed again (see ComponentPool::ForEachDirty).
+	*
+	*	Must be called before the dirty marks are cleared.
+	*/
+	inline void RefreshDirty( )
+	{
+		_pool.ForEachDirty( [ this ] ( const ComponentHandle<ComponentType> &handle, const ComponentType *component )
+		{
+			Insert( handle, *component );
+		} );
+	}
+
+	/**
+	*	Empties the index and indexes every component of the pool.
+	*/
+	inline void Rebuild( )
+	{
+		_buckets.clear( );
+		_entries.clear( );
+		_size = 0;
+
+		_pool.ForEach( [ this ] ( const ComponentHandle<ComponentType> &handle, const ComponentType *component )
+		{
+			Insert( handle, *component );
+		} );
+	}
+
+	inline void OnCreate( const ComponentHandle<ComponentType> *handles, size_t count ) override
+	{
+		for ( size_t i = 0; i < count; i++ )
+			Refresh( handles [ i ] );
+
+		if ( _next )
+			_next->OnCreate( handles, count );
+	}
+
+	inline void OnDelete( const ComponentHandle<ComponentType> *handles, size_t count ) override
+	{
+		for ( size_t i = 0; i < count; i++ )
+			Remove( handles [ i ] );
+
+		if ( _next )
+			_next->OnDelete( handles, count );
+	}
+
+	inline void OnWake( const ComponentHandle<ComponentType> *handles, size_t count ) override
+	{
+		if ( _next )
+			_next->OnWake( handles, count );
+	}
+
+	inline void OnSleep( const ComponentHandle<ComponentType> *handles, size_t count ) override
+	{
+		if ( _next )
+			_next->OnSleep( handles, count );
+	}
+
+private:
+
+	/**
+	*	Where a component sits in the index, kept for each control block slot.
+	*/
+	struct Entry
+	{
+		inline Entry( )
+			: _position( 0 )
+			, _generation( 0 )
+			, _indexed( false )
+		{
+
+		}
+
+		/**< The key the component is indexed under. */
+		KeyType _key;
+
+		/**< The position of the component in the bucket of its key. */
+		size_t _position;
+
+		/**< The generation of the indexed component. */
+		uint32_t _generation;
+
+		/**< Whether a component of the slot is indexed. */
+		bool _indexed;
+	};
+
+	/**
+	*	Indexes a component under its current key, replacing whatever the slot of its handle was indexed as.
+	*/
+	inline void Insert( const ComponentHandle<ComponentType> &handle, const ComponentType &component )
+	{
+		auto key = _key( component );
+
+		// Make sure the slot has an entry (may throw)
+		const auto slot = handle.GetSlot( );
+		if ( slot >= _entries.size( ) )
+			_entries.resize( slot + 1 );
+
+		// Components that keep their key stay where they are
+		auto &entry = _entries [ slot ];
+		if ( entry._indexed && entry._generation == handle.GetGeneration( ) && entry._key == key )
+			return;
+
+		// Take the slot out of the bucket it was in, which may have been the bucket of the key
+		if ( entry._indexed )
+			Unlink( slot );
+
+		// A component that does not fit in its bucket is left out of the index, along with any bucket made for it (may throw)
+		auto found = _buckets.find( key );
+		const auto is_new_bucket = found == _buckets.end( );
+		if ( is_new_bucket )
+			found = _buckets.emplace( key, std::vector<ComponentHandle<ComponentType>>( ) ).first;
+
+		auto &bucket = found->second;
+		try
+		{
+			bucket.reserve( bucket.size( ) + 1 );
+		}
+		catch ( ... )
+		{
+			if ( is_new_bucket )
+				_buckets.erase( found );
+			throw;
+		}
+
+		entry._key = std::move( key );
+		entry._position = bucket.size( );
+		entry._generation = handle.GetGeneration( );
+		entry._indexed = true;
+		bucket.push_back( handle );
+		_size++;
+	}
+
+	/**
+	*	Drops a component from the index, unless the slot of its handle has moved on to another component.
+	*/
+	inline void Remove( const ComponentHandle<ComponentType> &handle )
+	{
+		const auto slot = handle.GetSlot( );
+		if ( slot < _entries.size( ) && _entries [ slot ]._indexed && _entries [ slot ]._generation == handle.GetGeneration( ) )
+			Unlink( slot );
+	}
+
+	/**
+	*	Takes the component of an indexed slot out of its bucket, moving the last component of the bucket into its place.
+	*/
+	inline void Unlink( uint32_t slot )
+	{
+		auto &entry = _entries [ slot ];
+		const auto bucket = _buckets.find( entry._key );
+		auto &handles = bucket->second;
+
+		handles [ entry._position ] = handles.back( );
+		_entries [ handles [ entry._position ].GetSlot( ) ]._position = entry._position;
+		handles.pop_back( );
+		if ( handles.empty( ) )
+			_buckets.erase( bucket );
+
+		entry._indexed = false;
+		_size--;
+	}
+
+	/**< The indexed pool. */
+	const ComponentPool<ComponentType, Traits> &_pool;
+
+	/**< Gives the key of a component. */
+	KeyFunction _key;
+
+	/**< The listener events are passed on to. */
+	ComponentPoolListener<ComponentType> *_next;
+
+	/**< The handles of the components of each key. */
+	std::unordered_map<KeyType, std::vector<ComponentHandle<ComponentType>>, Hash> _buckets;
+
+	/**< Where each control block slot is indexed. */
+	std::vector<Entry> _entries;
+
+	/**< The number of indexed components. */
+	size_t _size;
+};
+
+/**
+*	A point in space, as indexed by ComponentGridIndex.
+*/
+struct ComponentGridPosition
+{
+	float _x;
+	float _y;
+	float _z;
+};
+
+/**
+*	Indexes the components of a pool by their position in a uniform grid, answering queries for the components within a radius.
+*
+*	The index follows the pool like ComponentKeyIndex does, and moving components have to be refreshed the same way. 
+*	Each cell keeps the handles and positions of its components next to each other, so a query only reads the cells 
+*	that overlap its sphere and tests the positions without touching the components. Cells should be about the size 
+*	of a typical query radius. Positions are kept to 2^20 cells from the origin along each axis, and 2D users can 
+*	leave z at zero.
+*/
+template <typename ComponentType, typename Traits = ComponentPoolTraits<ComponentType>>
+class ComponentGridIndex final : public ComponentPoolListener<ComponentType>
+{
+public:
+
+	/**< Gives the position of a component. */
+	typedef std::function<ComponentGridPosition( const ComponentType& )> PositionFunction;
+
+	/**
+	*	Constructs an empty index.
+	*
+	*	@param pool the pool to index, which must outlive the index
+	*	@param cell_size the length of the sides of each cell
+	*	@param position the function giving the position of a component
+	*	@param next the listener to pass events on to, null if there is none
+	*/
+	inline ComponentGridIndex( const ComponentPool<ComponentType, Traits> &pool, float cell_size, PositionFunction position, ComponentPoolListener<ComponentType> *next = nullptr )
+		: _pool( pool )
+		, _inverse_cell_size( 1.0f / cell_size )
+		, _position( std::move( position ) )
+		, _next( next )
+		, _size( 0 )
+	{
+		if ( !( cell_size > 0 ) )
+			throw std::runtime_error( "Grid cells must have a positive size." );
+	}
+
+	/**
+	*	Adds the components within the given distance of a point to the handles.
+	*
+	*	@param center the point to search around
+	*	@param radius the distance to search within
+	*	@param handles receives the handles of the components found, in no particular order
+	*/
+	inline void Query( const ComponentGridPosition &center, float radius, std::vector<ComponentHandle<ComponentType>> &handles ) const
+	{
+		// Get the range of cells the sphere overlaps
+		const auto min_x = CellCoordinate( center._x - radius ), max_x = CellCoordinate( center._x + radius );
+		const auto min_y = CellCoordinate( center._y - radius ), max_y = CellCoordinate( center._y + radius );
+		const auto min_z = CellCoordinate( center._z - radius ), max_z = CellCoordinate( center._z + radius );
+		const auto radius_squared = radius * radius;
+
+		// Ranges with more cells than the index holds are cheaper to check by going over the cells that hold components
+		const auto num_range_cells = static_cast< uint64_t >( max_x - min_x + 1 ) * static_cast< uint64_t >( max_y - min_y + 1 ) * static_cast< uint64_t >( max_z - min_z + 1 );
+		if ( num_range_cells > _cells.size( ) )
+		{
+			for ( const auto &cell : _cells )
+			{
+				const auto x = KeyCoordinate( cell.first, 2 * COORDINATE_BITS ), y = KeyCoordinate( cell.first, COORDINATE_BITS ), z = KeyCoordinate( cell.first, 0 );
+				if ( x >= min_x && x <= max_x && y >= min_y && y <= max_y && z >= min_z && z <= max_z )
+					QueryCell( cell.second, center, radius_squared, handles );
+			}
+			return;
+		}
+
+		for ( auto x = min_x; x <= max_x; x++ )
+		{
+			for ( auto y = min_y; y <= max_y; y++ )
+			{
+				for ( auto z = min_z; z <= max_z; z++ )
+				{
+					const auto cell = _cells.find( CellKey( x, y, z ) );
+					if ( cell != _cells.end( ) )
+						QueryCell( cell->second, center, radius_squared, handles );
+				}
+			}
+		}
+	}
+
+	/**
+	*	Gets the number of components in the index.
+	*/
+	inline size_t Size( ) const { return _size; }
+
+	/**
+	*	Takes the position of a component again after it moved. Components that are gone are dropped from the index.
+	*/
+	inline void Refresh( const ComponentHandle<ComponentType> &handle )
+	{
+		const auto *const component = _pool.Resolve( handle );
+		if ( component )
+			Insert( handle, *component );
+		else
+			Remove( handle );
+	}
+
+	/**
+	*	Takes the positions of the active components marked as changed again (see ComponentPool::ForEachDirty).
+	*
+	*	Must be called before the dirty marks are cleared.
+	*/
+	inline void RefreshDirty( )
+	{
+		_pool.ForEachDirty( [ this ] ( const ComponentHandle<ComponentType> &handle, const ComponentType *component )
+		{
+			Insert( handle, *component );
+		} );
+	}
+
+	/**
+	*	Empties the index and indexes every component of the pool.
+	*/
+	inline void Rebuild( )
+	{
+		_cells.clear( );
+		_entries.clear( );
+		_size = 0;
+
+		_pool.ForEach( [ this ] ( const ComponentHandle<ComponentType> &handle, const ComponentType *component )
+		{
+			Insert( handle, *component );
+		} );
+	}
+
+	inline void OnCreate( const ComponentHandle<ComponentType> *handles, size_t count ) override
+	{
+		for ( size_t i = 0; i < count; i++ )
+			Refresh( handles [ i ] );
+
+		if ( _next )
+			_next->OnCreate( handles, count );
+	}
+
+	inline void OnDelete( const ComponentHandle<ComponentType> *handles, size_t count ) override
+	{
+		for ( size_t i = 0; i < count; i++ )
+			Remove( handles [ i ] );
+
+		if ( _next )
+			_next->OnDelete( handles, count );
+	}
+
+	inline void OnWake( const ComponentHandle<ComponentType> *handles, size_t count ) override
+	{
+		if ( _next )
+			_next->OnWake( handles, count );
+	}
+
+	inline void OnSleep( const ComponentHandle<ComponentType> *handles, size_t count ) override
+	{
+		if ( _next )
+			_next->OnSleep( handles, count );
+	}
+
+private:
+
+	/**< The number of bits of each cell coordinate in a cell key. */
+	static const int COORDINATE_BITS = 21;
+
+	/**< The furthest cell from the origin along each axis. */
+	static const int32_t MAX_COORDINATE = ( 1 << ( COORDINATE_BITS - 1 ) ) - 1;
+
+	/**
+	*	The components of one cell.
+	*/
+	struct Cell
+	{
+		/**< The handles of the components. */
+		std::vector<ComponentHandle<ComponentType>> _handles;
+
+		/**< The positions of the components. */
+		std::vector<ComponentGridPosition> _positions;
+	};
+
+	/**
+	*	Where a component sits in the index, kept for each control block slot.
+	*/
+	struct Entry
+	{
+		inline Entry( )
+			: _cell( 0 )
+			, _position( 0 )
+			, _generation( 0 )
+			, _indexed( false )
+		{
+
+		}
+
+		/**< The key of the cell the component is in. */
+		uint64_t _cell;
+
+		/**< The position of the component in its cell. */
+		size_t _position;
+
+		/**< The generation of the indexed component. */
+		uint32_t _generation;
+
+		/**< Whether a component of the slot is indexed. */
+		bool _indexed;
+	};
+
+	/**
+	*	Gets the cell coordinate of a position along one axis, clamped to the extent of the grid.
+	*/
+	inline int32_t CellCoordinate( float position ) const
+	{
+		const auto coordinate = std::floor( position * _inverse_cell_size );
+		if ( !( coordinate > -MAX_COORDINATE ) )
+			return -MAX_COORDINATE;
+		if ( !( coordinate < MAX_COORDINATE ) )
+			return MAX_COORDINATE;
+
+		return static_cast< int32_t >( coordinate );
+	}
+
+	/**
+	*	Packs the coordinates of a cell into its key.
+	*/
+	static inline uint64_t CellKey( int32_t x, int32_t y, int32_t z )
+	{
+		const uint64_t mask = ( uint64_t( 1 ) << COORDINATE_BITS ) - 1;
+		return ( ( static_cast< uint64_t >( x ) & mask ) << ( 2 * COORDINATE_BITS ) ) | ( ( static_cast< uint64_t >( y ) & mask ) << COORDINATE_BITS ) | ( static_cast< uint64_t >( z ) & mask );
+	}
+
+	/**
+	*	Unpacks the coordinate of a cell along one axis from its key.
+	*
+	*	@param key the key of the cell
+	*	@param shift the position of the coordinate in the key
+	*/
+	static inline int32_t KeyCoordinate( uint64_t key, int shift )
+	{
+		const uint64_t mask = ( uint64_t( 1 ) << COORDINATE_BITS ) - 1;
+		const auto coordinate = static_cast< int32_t >( ( key >> shift ) & mask );
+
+		// Coordinates are stored in two's complement within their bits
+		return coordinate > MAX_COORDINATE ? coordinate - ( 1 << COORDINATE_BITS ) : coordinate;
+	}
+
+	/**
+	*	Adds the components of a cell within the given squared distance of a point to the handles.
+	*/
+	static inline void QueryCell( const Cell &cell, const ComponentGridPosition &center, float radius_squared, std::vector<ComponentHandle<ComponentType>> &handles )
+	{
+		// Test the positions of the cell one after the other
+		const auto &positions = cell._positions;
+		for ( size_t i = 0; i < positions.size( ); i++ )
+		{
+			const auto dx = positions [ i ]._x - center._x;
+			const auto dy = positions [ i ]._y - center._y;
+			const auto dz = positions [ i ]._z - center._z;
+			if ( dx * dx + dy * dy + dz * dz <= radius_squared )
+				handles.push_back( cell._handles [ i ] );
+		}
+	}
+
+	/**
+	*	Indexes a component at its current position, replacing whatever the slot of its handle was indexed as.
+	*/
+	inline void Insert( const ComponentHandle<ComponentType> &handle, const ComponentType &component )
+	{
+		const auto position = _position( component );
+		const auto key = CellKey( CellCoordinate( position._x ), CellCoordinate( position._y ), CellCoordinate( position._z ) );
+
+		// Make sure the slot has an entry (may throw)
+		const auto slot = handle.GetSlot( );
+		if ( slot >= _entries.size( ) )
+			_entries.resize( slot + 1 );
+
+		// Components that stay in their cell only need their position updated
+		auto &entry = _entries [ slot ];
+		if ( entry._indexed && entry._generation == handle.GetGeneration( ) && entry._cell == key )
+		{
+			_cells.find( key )->second._positions [ entry._position ] = position;
+			return;
+		}
+
+		// Take the slot out of the cell it was in, which may have been the cell of the position
+		if ( entry._indexed )
+			Unlink( slot );
+
+		// A component that does not fit in its cell is left out of the index, along with any cell made for it (may throw)
+		auto found = _cells.find( key );
+		const auto is_new_cell = found == _cells.end( );
+		if ( is_new_cell )
+			found = _cells.emplace( key, Cell( ) ).first;
+
+		auto &cell = found->second;
+		try
+		{
+			cell._handles.reserve( cell._handles.size( ) + 1 );
+			cell._positions.reserve( cell._positions.size( ) + 1 );
+		}
+		catch ( ... )
+		{
+			if ( is_new_cell )
+				_cells.erase( found );
+			throw;
+		}
+
+		entry._cell = key;
+		entry._position = cell._handles.size( );
+		entry._generation = handle.GetGeneration( );
+		entry._indexed = true;
+		cell._handles.push_back( handle );
+		cell._positions.push_back( position );
+		_size++;
+	}
+
+	/**
+	*	Drops a component from the index, unless the slot of its handle has moved on to another component.
+	*/
+	inline void Remove( const ComponentHandle<ComponentType> &handle )
+	{
+		const auto slot = handle.GetSlot( );
+		if ( slot < _entries.size( ) && _entries [ slot ]._indexed && _entries [ slot ]._generation == handle.GetGeneration( ) )
+			Unlink( slot );
+	}
+
+	/**
+	*	Takes the component of an indexed slot out of its cell, moving the last component of the cell into its place.
+	*/
+	inline void Unlink( uint32_t slot )
+	{
+		auto &entry = _entries [ slot ];
+		const auto cell = _cells.find( entry._cell );
+		auto &handles = cell->second._handles;
+		auto &positions = cell->second._positions;
+
+		handles [ entry._position ] = handles.back( );
+		positions [ entry._position ] = positions.back( );
+		_entries [ handles [ entry._position ].GetSlot( ) ]._position = entry._position;
+		handles.pop_back( );
+		positions.pop_back( );
+		if ( handles.empty( ) )
+			_cells.erase( cell );
+
+		entry._indexed = false;
+		_size--;
+	}
+
+	/**< The indexed pool. */
+	const ComponentPool<ComponentType, Traits> &_pool;
+
+	/**< The number of cells per unit of length. */
+	float _inverse_cell_size;
+
+	/**< Gives the position of a component. */
+	PositionFunction _position;
+
+	/**< The listener events are passed on to. */
+	ComponentPoolListener<ComponentType> *_next;
+
+	/**< The non-empty cells, keyed by their packed coordinates. */
+	std::unordered_map<uint64_t, Cell> _cells;
+
+	/**< Where each control block slot is indexed. */
+	std::vector<Entry> _entries;
+
+	/**< The number of indexed components. */
+	size_t _size;
+};
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdint>
+#include <memory>
+
+#include "ChunkedArray.h"
+#include "ComponentReferenceControlBlock.h"
+
+/**
+*	Locates the control blocks and components of one component pool for component references.
+*
+*	Every component pool owns one locator, and references keep a pointer to it alongside the control block index.
+*	Lookups only go through chunked array views, so they stay valid while the pool grows.
+*/
+template <typename ComponentType>
+class ComponentLocator final
+{
+public:
+
+	/**
+	*	Constructs a locator.
+	*
+	*	@param control_blocks the control blocks of the pool
+	*	@param components the components of the pool, null if the pool does not store component objects
+	*	@param dirty the dirty marks of the components, null if the pool does not track changes
+	*/
+	inline ComponentLocator( const ChunkedArrayView<ComponentReferenceControlBlock> &control_blocks, const ChunkedArrayView<ComponentType> *components, const ChunkedArrayView<uint8_t> *dirty = nullptr )
+		: _control_blocks( control_blocks )
+		, _components( components )
+		, _dirty( dirty )
+	{
+
+	}
+
+	/**
+	*	Locator copying is forbidden.
+	*/
+	ComponentLocator( ComponentLocator const& ) = delete;
+
+	/**
+	*	Locator copying is forbidden.
+	*/
+	ComponentLocator& operator=( ComponentLocator const& ) = delete;
+
+	/**
+	*	Gets the control block at the given index.
+	*/
+	inline const ComponentReferenceControlBlock& GetControlBlock( ComponentReferenceControlBlock::IndexType index ) const
+	{
+		return _control_blocks.At( index );
+	}
+
+	/**
+	*	Gets the component at the given index.
+	*
+	*	@returns the component, or null if the index is the null index or the pool does not store component objects
+	*/
+	inline ComponentType* GetComponent( ComponentReferenceControlBlock::IndexType index ) const
+	{
+		if ( index == ComponentReferenceControlBlock::NULL_INDEX || !_components )
+			return nullptr;
+
+		return std::addressof( _components->At( index ) );
+	}
+
+	/**
+	*	Marks the component at the given index as changed, unless the index is the null index or the pool does not track changes.
+	*
+	*	Each component has a mark of its own, so components may be marked from several threads at once.
+	*/
+	inline void MarkDirty( ComponentReferenceControlBlock::IndexType index ) const
+	{
+		if ( index == ComponentReferenceControlBlock::NULL_INDEX || !_dirty )
+			return;
+
+		_dirty->At( index ) = 1;
+	}
+
+private:
+
+	/**< The control blocks of the pool. */
+	const ChunkedArrayView<ComponentReferenceControlBlock> &_control_blocks;
+
+	/**< The components of the pool. */
+	const ChunkedArrayView<ComponentType> *_components;
+
+	/**< The dirty marks of the components. */
+	const ChunkedArrayView<uint8_t> *_dirty;
+};
\ No newline at end of file
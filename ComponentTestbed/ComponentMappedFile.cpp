@@ -0,0 +1,157 @@
+#include "stdafx.h"
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ComponentMappedFile.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+ComponentMappedFile::ComponentMappedFile( const char *path )
+	: _file( INVALID_HANDLE_VALUE )
+	, _mapping( nullptr )
+	, _data( nullptr )
+	, _size( 0 )
+	, _opened_size( 0 )
+{
+	_file = CreateFileA( path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if ( _file == INVALID_HANDLE_VALUE )
+		throw std::runtime_error( "Could not open the component pool file." );
+
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( _file, &size ) )
+	{
+		CloseHandle( _file );
+		throw std::runtime_error( "Could not get the size of the component pool file." );
+	}
+
+	_opened_size = static_cast< size_t >( size.QuadPart );
+}
+
+ComponentMappedFile::~ComponentMappedFile( )
+{
+	if ( _data )
+		UnmapViewOfFile( _data );
+	if ( _mapping )
+		CloseHandle( _mapping );
+	CloseHandle( _file );
+}
+
+void* ComponentMappedFile::Map( size_t size )
+{
+	if ( _data )
+		throw std::runtime_error( "Component pool file is already mapped." );
+
+	// Mapping past the end of the file grows it with zeroes
+	const auto mapping_size = static_cast< unsigned long long >( size );
+	_mapping = CreateFileMappingA( _file, nullptr, PAGE_READWRITE, static_cast< DWORD >( mapping_size >> 32 ), static_cast< DWORD >( mapping_size ), nullptr );
+	if ( !_mapping )
+		throw std::runtime_error( "Could not create a mapping of the component pool file." );
+
+	_data = MapViewOfFile( _mapping, FILE_MAP_ALL_ACCESS, 0, 0, size );
+	if ( !_data )
+	{
+		CloseHandle( _mapping );
+		_mapping = nullptr;
+		throw std::runtime_error( "Could not map the component pool file." );
+	}
+
+	_size = size;
+	return _data;
+}
+
+void ComponentMappedFile::Flush( )
+{
+	if ( _data && ( !FlushViewOfFile( _data, _size ) || !FlushFileBuffers( _file ) ) )
+		throw std::runtime_error( "Could not flush the component pool file." );
+}
+
+#else
+
+ComponentMappedFile::ComponentMappedFile( const char *path )
+	: _file( -1 )
+	, _data( nullptr )
+	, _size( 0 )
+	, _opened_size( 0 )
+{
+	_file = open( path, O_RDWR | O_CREAT, 0644 );
+	if ( _file < 0 )
+		throw std::runtime_error( "Could not open the component pool file." );
+
+	struct stat status;
+	if ( fstat( _file, &status ) != 0 )
+	{
+		close( _file );
+		throw std::runtime_error( "Could not get the size of the component pool file." );
+	}
+
+	_opened_size = static_cast< size_t >( status.st_size );
+}
+
+ComponentMappedFile::~ComponentMappedFile( )
+{
+	if ( _data )
+		munmap( _data, _size );
+	close( _file );
+}
+
+void* ComponentMappedFile::Map( size_t size )
+{
+	if ( _data )
+		throw std::runtime_error( "Component pool file is already mapped." );
+
+	// Grow the file with zeroes so every mapped page is backed
+	if ( size > _opened_size && ftruncate( _file, static_cast< off_t >( size ) ) != 0 )
+		throw std::runtime_error( "Could not grow the component pool file." );
+
+	auto *data = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0 );
+	if ( data == MAP_FAILED )
+		throw std::runtime_error( "Could not map the component pool file." );
+
+	_data = data;
+	_size = size;
+	return _data;
+}
+
+void ComponentMappedFile::Flush( )
+{
+	if ( _data && msync( _data, _size, MS_SYNC ) != 0 )
+		throw std::runtime_error( "Could not flush the component pool file." );
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+*	A file mapped into memory, used to back component pools that persist between runs (see ComponentPool).
+*
+*	The file is opened or created on construction and mapped once with Map. Pages of the file are loaded on demand 
+*	as they are touched and written back by the operating system, or straight away by Flush.
+*/
+class ComponentMappedFile final
+{
+public:
+
+	/**
+	*	Opens the file at the given path, creating it if it does not exist.
+	*
+	*	@param path the path of the file
+	*/
+	explicit ComponentMappedFile( const char *path );
+
+	/**
+	*	Unmaps and closes the file.
+	*/
+	~ComponentMappedFile( );
+
+	/**
+	*	Mapped file copying is forbidden.
+	*/
+	ComponentMappedFile( ComponentMappedFile const& ) = delete;
+
+	/**
+	*	Mapped file copying is forbidden.
+	*/
+	ComponentMappedFile& operator=( ComponentMappedFile const& ) = delete;
+
+	/**
+	*	Maps the start of the file into memory, growing the file with zeroes first if it is smaller. May only be called once.
+	*
+	*	@param size the number of bytes to map
+	*	@returns the first byte of the mapping
+	*/
+	void* Map( size_t size );
+
+	/**
+	*	Writes the changed pages of the mapping back to the file.
+	*/
+	void Flush( );
+
+	/**
+	*	Gets the size of the file when it was opened, zero if it was created.
+	*/
+	inline size_t GetOpenedSize( ) const { return _opened_size; }
+
+	/**
+	*	Gets the first byte of the mapping, null if the file has not been mapped yet.
+	*/
+	inline void* GetData( ) const { return _data; }
+
+	/**
+	*	Gets the number of bytes mapped.
+	*/
+	inline size_t GetSize( ) const { return _size; }
+
+private:
+
+#ifdef _WIN32
+	/**< The file handle. */
+	void *_file;
+
+	/**< The file mapping object handle. */
+	void *_mapping;
+#else
+	/**< The file descriptor. */
+	int _file;
+#endif
+
+	/**< The first byte of the mapping. */
+	void *_data;
+
+	/**< The number of bytes mapped. */
+	size_t _size;
+
+	/**< The size of the file when it was opened. */
+	size_t _opened_size;
+};
\ No newline at end of file
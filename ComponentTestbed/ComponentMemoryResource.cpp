@@ -0,0 +1,106 @@
+#include "stdafx.h"
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ComponentMemoryResource.h"
+
+#include <cstdint>
+#include <new>
+
+ComponentArenaMemoryResource::ComponentArenaMemoryResource( size_t block_size )
+	: _cursor( nullptr )
+	, _end( nullptr )
+	, _block_size( block_size )
+	, _num_bytes_reserved( 0 )
+{
+
+}
+
+ComponentArenaMemoryResource::~ComponentArenaMemoryResource( )
+{
+	Release( );
+}
+
+void* ComponentArenaMemoryResource::Allocate( size_t size, size_t alignment )
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	// Carve the block out of the current allocation if it fits
+	if ( _cursor )
+	{
+		const auto address = ( reinterpret_cast< std::uintptr_t >( _cursor ) + alignment - 1 ) & ~static_cast< std::uintptr_t >( alignment - 1 );
+		if ( address + size <= reinterpret_cast< std::uintptr_t >( _end ) )
+		{
+			_cursor = reinterpret_cast< char* >( address + size );
+			return reinterpret_cast< void* >( address );
+		}
+	}
+
+	// Make room for the allocation so the insert below cannot throw
+	_allocations.reserve( _allocations.size( ) + 1 );
+
+	// Allocate with enough slack to align the block, oversized blocks get an allocation of their own (may throw)
+	const auto allocation_size = size + alignment - 1 > _block_size ? size + alignment - 1 : _block_size;
+	auto *allocation = static_cast< char* >( ::operator new( allocation_size ) );
+	_allocations.push_back( allocation );
+	_num_bytes_reserved += allocation_size;
+
+	const auto address = ( reinterpret_cast< std::uintptr_t >( allocation ) + alignment - 1 ) & ~static_cast< std::uintptr_t >( alignment - 1 );
+
+	// Keep carving from whichever allocation has more room left
+	auto *const block_end = reinterpret_cast< char* >( address + size );
+	if ( !_cursor || allocation + allocation_size - block_end > _end - _cursor )
+	{
+		_cursor = block_end;
+		_end = allocation + allocation_size;
+	}
+
+	return reinterpret_cast< void* >( address );
+}
+
+void ComponentArenaMemoryResource::Deallocate( void *, size_t, size_t ) _NOEXCEPT
+{
+
+}
+
+void ComponentArenaMemoryResource::Release( ) _NOEXCEPT
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+
+	for ( auto *allocation : _allocations )
+		::operator delete( allocation );
+
+	_allocations.clear( );
+	_cursor = nullptr;
+	_end = nullptr;
+	_num_bytes_reserved = 0;
+}
+
+size_t ComponentArenaMemoryResource::GetNumBytesReserved( ) const
+{
+	std::lock_guard<std::mutex> lock( _mutex );
+	return _num_bytes_reserved;
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+*	A source of raw memory for the chunks of component pools.
+*
+*	Component pools, their storages and their control block pools take their chunks from a memory resource when given 
+*	one, and from the global operator new otherwise. Implement this to place pools in NUMA local memory, large pages 
+*	or an arena (see ComponentArenaMemoryResource). Only chunk storage goes through the resource, the bookkeeping of 
+*	each pool stays on the heap.
+*
+*	A resource used by pools that create components from several threads, or by pools updated concurrently, must be thread safe.
+*/
+class ComponentMemoryResource
+{
+public:
+
+	/**
+	*	Destroys a memory resource.
+	*/
+	virtual ~ComponentMemoryResource( ) { }
+
+	/**
+	*	Allocates a block of memory, throwing if it cannot.
+	*
+	*	@param size the size of the block in bytes
+	*	@param alignment the alignment of the block, a power of two
+	*	@returns the start of the block
+	*/
+	virtual void* Allocate( size_t size, size_t alignment ) = 0;
+
+	/**
+	*	Returns a block of memory handed out by Allocate.
+	*
+	*	@param address the start of the block
+	*	@param size the size the block was allocated with
+	*	@param alignment the alignment the block was allocated with
+	*/
+	virtual void Deallocate( void *address, size_t size, size_t alignment ) _NOEXCEPT = 0;
+};
+
+/**
+*	A memory resource that carves blocks out of large allocations and frees them all at once.
+*
+*	Deallocate does nothing, so pools kept in the arena hand their chunks back for free, and Release (or destroying 
+*	the arena) frees everything in one go. EG: One arena per level, with every pool of the level destroyed before the 
+*	arena is released. Thread safe.
+*/
+class ComponentArenaMemoryResource final : public ComponentMemoryResource
+{
+public:
+
+	/**
+	*	Constructs an empty arena.
+	*
+	*	@param block_size the size of the allocations the arena carves blocks out of, larger blocks get an allocation of their own
+	*/
+	explicit ComponentArenaMemoryResource( size_t block_size = DEFAULT_BLOCK_SIZE );
+
+	/**
+	*	Frees all memory of the arena.
+	*/
+	~ComponentArenaMemoryResource( );
+
+	/**
+	*	Arena copying is forbidden.
+	*/
+	ComponentArenaMemoryResource( ComponentArenaMemoryResource const& ) = delete;
+
+	/**
+	*	Arena copying is forbidden.
+	*/
+	ComponentArenaMemoryResource& operator=( ComponentArenaMemoryResource const& ) = delete;
+
+	/**
+	*	Carves a block out of the current allocation, making a new allocation if it does not fit.
+	*/
+	void* Allocate( size_t size, size_t alignment ) override;
+
+	/**
+	*	Does nothing, blocks are only freed by Release.
+	*/
+	void Deallocate( void *address, size_t size, size_t alignment ) _NOEXCEPT override;
+
+	/**
+	*	Frees every block handed out by the arena. Nothing may use them afterwards.
+	*/
+	void Release( ) _NOEXCEPT;
+
+	/**
+	*	Gets the number of bytes of the allocations the arena currently holds.
+	*/
+	size_t GetNumBytesReserved( ) const;
+
+private:
+
+	/**< The default size of the allocations blocks are carved out of. */
+	static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+	/**< The allocations of the arena. */
+	std::vector<void*> _allocations;
+
+	/**< The next free byte of the current allocation. */
+	char *_cursor;
+
+	/**< One past the last byte of the current allocation. */
+	char *_end;
+
+	/**< The size of the allocations blocks are carved out of. */
+	const size_t _block_size;
+
+	/**< The number of bytes of the allocations. */
+	size_t _num_bytes_reserved;
+
+	/**< Guards the allocations. */
+	mutable std::mutex _mutex;
+};
\ No newline at end of file
@@ -25,43 +25,130 @@
 * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "CRCBPool.h"
+#include "ChunkedArray.h"
+#include "ComponentHandle.h"
+#include "ComponentLocator.h"
+#include "ComponentMappedFile.h"
+#include "ComponentPoolListener.h"
+#include "ComponentPoolStats.h"
+#include "ComponentPoolTraits.h"
+#include "ComponentPrefetch.h"
+#include "ComponentPublisher.h"
 #include "ComponentReference.h"
+#include "ComponentSerialization.h"
+#include "ComponentTimingWheel.h"
+#include "ComponentValidation.h"
 
 /**
 *	Manages an object pool of components in a cache coherent manner for the update tick.
 *
-*	Assumes components are freely movable.
+*	Assumes components are freely movable. Storage grows a chunk at a time, so components never 
+*	relocate due to growth and the active range is contiguous within each chunk.
+*
+*	Component storage is left uninitialized until a component is created, so only the slots [0, Count()) 
+*	hold live components and component types do not need to be default constructible.
+*
+*	SetActive, Delete and CreateDeferred may be called from any thread while components are updating.
+*	Their changes are recorded and applied by LateUpdate, which along with every other method must only be 
+*	called from the thread that owns the pool.
 */
-template <typename ComponentType>
+template <typename ComponentType, typename Traits = ComponentPoolTraits<ComponentType>>
 class ComponentPool
 {
-	// Assert assumptions over component type
-	static_assert( std::is_nothrow_move_assignable<ComponentType>::value, "Component classes must be nothrow move assignable." );
-	static_assert( std::is_nothrow_destructible<ComponentType>::value, "Component classes must be nothrow destructible." );
-
 	// Assert assumptions over CRCBs
-	static_assert( std::is_nothrow_move_assignable<ComponentReferenceControlBlock>::value, "ComponentReferenceControlBlock must be nothrow move assignable." );
-	static_assert( std::is_nothrow_destructible<ComponentReferenceControlBlock>::value, "ComponentReferenceControlBlock must be nothrow destructible." );
-	static_assert( std::is_nothrow_constructible<ComponentReferenceControlBlock, void*>::value, "ComponentReferenceControlBlock must be nothrow constructible when taking a component pointer." );
+	static_assert( std::is_trivially_destructible<ComponentReferenceControlBlock>::value, "ComponentReferenceControlBlock must be trivially destructible as control blocks are never destructed." );
+	static_assert( sizeof( ComponentReferenceControlBlock ) <= 16, "ComponentReferenceControlBlock should fit four to a cache line." );
+
+	/**< The type of control block and component indices. */
+	typedef ComponentReferenceControlBlock::IndexType IndexType;
+
+	/**< The number of components allocated at a time when the pool needs to grow. */
+	static const size_t CHUNK_SIZE = Traits::CHUNK_SIZE;
+
+	/**< The storage components live in, which also checks the assumptions over the component type. */
+	typedef typename Traits::template Storage<ComponentType, CHUNK_SIZE> StorageType;
+
+	/**< The pool control blocks are allocated from. */
+	typedef typename Traits::template ControlBlockPool<CHUNK_SIZE> ControlBlockPoolType;
+
+	/**< Whether the active block can be copied out to a ComponentPublisher. */
+	static const bool IS_PUBLISHABLE = std::is_copy_constructible<ComponentType>::value && std::is_same<StorageType, ComponentStorage<ComponentType, CHUNK_SIZE>>::value;
 
-	/**< The maximum amount of components pools should allow for. */
-	static const size_t MAX_COMPONENTS = 1000;
+	/**< Whether the pool keeps a dirty mark for every component. */
+	static const bool TRACK_CHANGES = Traits::TRACK_CHANGES;
+
+	// Batches must evenly divide chunks
+	static_assert( Traits::UPDATE_BATCH_SIZE > 0 && ( Traits::UPDATE_BATCH_SIZE & ( Traits::UPDATE_BATCH_SIZE - 1 ) ) == 0, "Update batch size must be a power of two." );
 
 public:
 
 	/**
 	*	Constructs a component pool.
+	*
+	*	The chunks of components, control blocks and the control table are allocated from the memory resource, which 
+	*	must outlive the pool. Pools kept in an arena still have to be destroyed before the arena is released.
+	*
+	*	@param max_components the maximum amount of components the pool should allow for
+	*	@param resource the memory resource to allocate chunks from, null for the global operator new
 	*/
-	inline ComponentPool( )
-		: _pending_changes_head( nullptr )
+	inline explicit ComponentPool( size_t max_components = std::numeric_limits<size_t>::max( ), ComponentMemoryResource *resource = nullptr )
+		: _control_block_pool( resource )
+		, _components( resource )
+		, _dirty( resource )
+		, _locator( _control_block_pool.GetView( ), _components.GetView( ), TRACK_CHANGES ? &_dirty : nullptr )
+		, _control_table( resource )
+		, _pending_changes_head( ComponentReferenceControlBlock::NULL_INDEX )
+		, _sort_begin( 0 )
+		, _sort_cursor( 0 )
+		, _time( 0 )
+		, _publisher( nullptr )
+		, _listener( nullptr )
 		, _num_active_components( 0 )
 		, _num_sleeping_components( 0 )
+		, _max_components( max_components < ComponentReferenceControlBlock::NULL_INDEX ? max_components : ComponentReferenceControlBlock::NULL_INDEX )
+		, _mapped_header( nullptr )
+	{
+
+	}
+
+	/**
+	*	Constructs a component pool that keeps its components, control blocks and control table in a mapped file.
+	*
+	*	If the file already holds a pool, the pool comes up as it was at the end of the last LateUpdate before the file was 
+	*	last written, without touching any component or control block, and pages are loaded as they are used. Otherwise the 
+	*	file is laid out for the given capacity. The capacity of the pool is fixed by the file either way.
+	*
+	*	Needs trivially copyable components kept in ComponentStorage. Every LateUpdate brings the counts and the control 
+	*	block free list in the file header up to date. The file must outlive the pool, and flushing it to disk is left to 
+	*	the operating system unless ComponentMappedFile::Flush is called.
+	*
+	*	@param file the file to keep the pool in, which must not have been mapped yet
+	*	@param capacity the maximum amount of components of a new file, rounded up to whole chunks
+	*/
+	inline ComponentPool( ComponentMappedFile &file, size_t capacity )
+		: ComponentPool( )
 	{
+		static_assert( std::is_trivially_copyable<ComponentType>::value, "Only trivially copyable components can be kept in a mapped file." );
+		static_assert( !ControlBlockPoolType::CONCURRENT, "Concurrent control block pools cannot be kept in a mapped file." );
 
+		MapStorage( file, capacity );
 	}
 
 	/**
@@ -69,10 +156,11 @@ public:
 	*/
 	inline ~ComponentPool( )
 	{
+		// Leave a mapped file describing the components it still holds
+		UpdateMappedHeader( );
+
 		// Destroy any remaining components allocated
-		const auto count = Count( );
-		for ( auto i = 0U; i < count; i++ )
-			_components [ i ].~ComponentType( );
+		_components.DestroyRange( 0, Count( ) );
 	}
 
 	/**
@@ -82,9 +170,89 @@ public:
 	*/
 	inline void Update( const float dt )
 	{
-		const auto count = Count( ); // Hoist loop check
-		for ( auto i = _num_sleeping_components; i < count; i++ )
-			_components [ i ].Update( dt );
+		COMPONENT_POOL_PROFILE_SCOPE( "ComponentPool::Update" );
+		COMPONENT_POOL_STAT( _stats._num_updates++ );
+
+		UpdateTimers( dt );
+		_components.Update( _num_sleeping_components, Count( ), dt );
+	}
+
+	/**
+	*	Updates all active components in the component pool across the given executor.
+	*
+	*	The active block is split into batches that start on cache line boundaries so jobs never share a cache line.
+	*	Component types that have not declared ComponentPoolTraits::CONCURRENT_UPDATE are updated serially.
+	*
+	*	Executors must provide Run( num_jobs, job ) which calls job( i ) for every i in [0, num_jobs) 
+	*	and returns once every call has completed. EG: ComponentWorkerPool.
+	*
+	*	@param dt the time since the last frame
+	*	@param executor the executor to run the update jobs on
+	*/
+	template <typename Executor>
+	inline void ParallelUpdate( const float dt, Executor &executor )
+	{
+		COMPONENT_POOL_PROFILE_SCOPE( "ComponentPool::ParallelUpdate" );
+
+		// Only update concurrently if the component type allows it
+		if ( !Traits::CONCURRENT_UPDATE )
+		{
+			Update( dt );
+			return;
+		}
+
+		COMPONENT_POOL_STAT( _stats._num_updates++ );
+
+		// Timers update components one at a time, so they are serviced before the jobs start
+		UpdateTimers( dt );
+
+		// Hoist constants
+		const auto begin = _num_sleeping_components;
+		const auto end = Count( );
+		const auto batch_size = UpdateBatchSize( );
+
+		// Is there anything to update
+		if ( begin == end )
+			return;
+
+		// Batches are aligned to multiples of the batch size so the first and last batch may be partial
+		const auto first_batch = begin / batch_size;
+		const auto num_batches = ( end - 1 ) / batch_size - first_batch + 1;
+
+		executor.Run( num_batches, [ this, dt, begin, end, batch_size, first_batch ] ( size_t job )
+		{
+			const auto job_begin = std::max( begin, ( first_batch + job ) * batch_size );
+			const auto job_end = std::min( end, ( first_batch + job + 1 ) * batch_size );
+
+			_components.Update( job_begin, job_end, dt );
+		} );
+	}
+
+	/**
+	*	Ensures the pool has storage for at least the given amount of components.
+	*
+	*	@param capacity the desired capacity
+	*/
+	inline void Reserve( size_t capacity )
+	{
+		// Never reserve past the allocation limit
+		capacity = std::min( capacity, _max_components );
+
+		_components.Reserve( capacity );
+		_control_table.Reserve( capacity );
+		ReserveDirty( capacity );
+
+		// Control blocks may be allocated concurrently by CreateDeferred
+		std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+		_control_block_pool.Reserve( capacity );
+	}
+
+	/**
+	*	Gets the number of components the pool currently has storage for.
+	*/
+	inline size_t Capacity( ) const
+	{
+		return _components.Capacity( );
 	}
 
 	/**
@@ -100,44 +268,170 @@ public:
 		const auto count = Count( );
 
 		// Can we create any more components 
-		if ( count == MAX_COMPONENTS )
+		if ( count == _max_components )
 			throw std::runtime_error( "Allocation limit reached for component store." );
 
-		// Grab a component reference control block (may throw)
-		auto control_block = _control_block_pool.Allocate( 1 );
+		// Make sure we have storage for the new component (may throw)
+		_components.Reserve( count + 1 );
+		_control_table.Reserve( count + 1 );
+		ReserveDirty( count + 1 );
 
-		// Grab a component
-		auto component = std::addressof( _components [ count ] );
+		// Make sure the create can be reported (may throw)
+		if ( _listener )
+			_events._created.reserve( _events._created.size( ) + 1 );
 
-		// Construct the new component (may throw)
+		// Grab a component reference control block (may throw)
+		const auto control_block = AllocateControlBlock( );
+
+		// Construct the new component in the uninitialized slot (may throw)
 		try
 		{
-			new ( component ) ComponentType( std::forward<Args>( args )... );
+			_components.Construct( count, std::forward<Args>( args )... );
 		}
 		catch ( ... )
 		{
 			// Return the control block
-			_control_block_pool.Deallocate( control_block, 1 );
+			DeallocateControlBlock( control_block );
 
 			// Rethrow construct exception
 			throw;
 		}
 		
 		// Set the control block data
-		_control_block_pool.Construct( control_block, component );
+		_control_block_pool.Construct( control_block, static_cast< IndexType >( count ) );
 
 		// Update id table to point to the new control block
 		_control_table [ count ] = control_block;
+		SetDirty( count, count + 1, true );
 
 		// We now have a valid component, update count
 		++_num_active_components;
+		COMPONENT_POOL_STAT( _stats._num_creates++ );
+		COMPONENT_POOL_STAT( RecordHighWaterMarks( ) );
+
+		if ( _listener )
+			RecordEvent( _events._created, control_block );
 
 		// Return the control_block for the component
-		return ComponentReference<ComponentType>( control_block );
+		return ComponentReference<ComponentType>( &_locator, control_block );
 	}
 
 	/**
-	*	Sets the active state of the component. Changes will be applied at the end of the frame.
+	*	Creates several new active components at once.
+	*
+	*	Storage and control blocks for the whole batch are set up in one go before any component is constructed,
+	*	and if any construction throws the batch is rolled back so either every component is created or none are.
+	*
+	*	@param num_components the number of components to create
+	*	@param references receives the component reference for each component
+	*	@param init the function giving the constructor argument of each component as init( i ) for i in [0, num_components)
+	*/
+	template <typename Initializer>
+	inline void CreateMany( size_t num_components, ComponentReference<ComponentType> *references, Initializer init )
+	{
+		// Hoist constants
+		const auto count = Count( );
+
+		// Can we create this many more components 
+		if ( num_components > _max_components - count )
+			throw std::runtime_error( "Allocation limit reached for component store." );
+
+		// Make sure we have storage for the new components (may throw)
+		_components.Reserve( count + num_components );
+		_control_table.Reserve( count + num_components );
+		ReserveDirty( count + num_components );
+		_batch_control_blocks.resize( num_components );
+		if ( _listener )
+			_events._created.reserve( _events._created.size( ) + num_components );
+
+		// Grab all of the component reference control blocks (may throw)
+		{
+			auto lock = LockControlBlocks( );
+			_control_block_pool.Allocate( num_components, _batch_control_blocks.data( ) );
+			COMPONENT_POOL_STAT( if ( lock.owns_lock( ) ) RecordControlBlockHighWaterMark( ) );
+		}
+
+		// Construct the new components in the uninitialized slots (may throw)
+		size_t num_constructed = 0;
+		try
+		{
+			for ( ; num_constructed < num_components; num_constructed++ )
+				_components.Construct( count + num_constructed, init( num_constructed ) );
+		}
+		catch ( ... )
+		{
+			// Destroy the components constructed so far and return the control blocks
+			_components.DestroyRange( count, count + num_constructed );
+
+			auto lock = LockControlBlocks( );
+			_control_block_pool.Deallocate( _batch_control_blocks.data( ), num_components );
+
+			// Rethrow construct exception
+			throw;
+		}
+
+		// Set the control block data and update the id table to point to the new control blocks
+		for ( size_t i = 0; i < num_components; i++ )
+		{
+			const auto control_block = _batch_control_blocks [ i ];
+			_control_block_pool.Construct( control_block, static_cast< IndexType >( count + i ) );
+			_control_table [ count + i ] = control_block;
+			references [ i ] = ComponentReference<ComponentType>( &_locator, control_block );
+			if ( _listener )
+				RecordEvent( _events._created, control_block );
+		}
+
+		SetDirty( count, count + num_components, true );
+
+		// We now have valid components, update count
+		_num_active_components += num_components;
+		COMPONENT_POOL_STAT( _stats._num_creates += num_components );
+		COMPONENT_POOL_STAT( RecordHighWaterMarks( ) );
+	}
+
+	/**
+	*	Creates a new active component at the end of the frame. Thread safe.
+	*
+	*	The returned reference is valid straight away but does not point at a component until the next LateUpdate.
+	*	It can be passed to SetActive and Delete in the meantime.
+	*
+	*	@param args the constructor arguments for the component, copied until the component is constructed
+	*	@returns the component reference for the component
+	*/
+	template <typename... Args>
+	inline ComponentReference<ComponentType> CreateDeferred( Args &&... args )
+	{
+		// Grab a component reference control block (may throw)
+		const auto control_block = AllocateControlBlock( );
+
+		try
+		{
+			// Record how to construct the component outside of the lock (may throw)
+			std::function<void( StorageType&, size_t )> construct = [ = ] ( StorageType &storage, size_t index ) mutable { storage.Construct( index, std::move( args )... ); };
+
+			// The control block has no component until the next late update
+			_control_block_pool.Construct( control_block, ComponentReferenceControlBlock::NULL_INDEX );
+			ControlBlock( control_block ).MarkPendingCreation( );
+
+			// Only recording the create needs the lock (may throw)
+			std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+			_deferred_creates.push_back( DeferredCreate( control_block, std::move( construct ) ) );
+		}
+		catch ( ... )
+		{
+			// Return the control block
+			DeallocateControlBlock( control_block );
+
+			// Rethrow copy exception
+			throw;
+		}
+
+		// Return the control_block for the component
+		return ComponentReference<ComponentType>( &_locator, control_block );
+	}
+
+	/**
+	*	Sets the active state of the component. Changes will be applied at the end of the frame. Thread safe.
 	*
 	*	@param component the component to change the active state of
 	*	@param new_active the desired active state for the component
@@ -148,33 +442,75 @@ public:
 		if ( !component.IsValid( ) )
 			throw std::runtime_error( "Component reference was invalid." );
 
-		// Extract context from reference
-		auto context = component._context;
-
 		// Ensure control block actually belongs to this pool
-		if ( !_control_block_pool.IsPointerValid( context ) )
+		if ( component._locator != &_locator )
 			throw std::runtime_error( "Tried to set active state of component that did not belong to this component pool." );
 
+		// Extract context from reference
+		auto &context = ControlBlock( component._context );
+
 		// If component active state is already in desired state, do nothing
-		if ( new_active == context->IsComponentActive( ) )
+		if ( new_active == context.IsComponentActive( ) )
 			return;
 
-		// Add component to the pending changes list (if we haven't done so already)
-		if ( !context->IsPendingChanges( ) )
+		// Mark component for pending changes and add it to the pending changes list (if nobody has done so already)
+		if ( context.MarkActiveStateChange( new_active ) )
+			PushPendingChanges( component._context );
+	}
+
+	/**
+	*	Updates the component every given number of frames instead of every frame.
+	*
+	*	The component is put to sleep at the end of the frame and is then updated where it lies in the sleeping block, 
+	*	by the Update that is due, with the time since its last update. Only the component timers due on a frame are 
+	*	visited. The schedule ends if the component is awake when its timer comes due, is deleted or is given a new schedule. 
+	*	Intervals of one frame or less cancel the schedule and wake the component. Schedules are not kept in snapshots or mapped files.
+	*
+	*	@param component the component to schedule
+	*	@param num_frames the number of frames between updates of the component
+	*/
+	inline void SetUpdateInterval( const ComponentReference<ComponentType> &component, uint32_t num_frames )
+	{
+		// Updating every frame is the same as being awake
+		if ( num_frames <= 1 )
 		{
-			// Point the new head to the current head
-			context->_next = _pending_changes_head;
+			WakeAndCancelTimer( component );
+			return;
+		}
 
-			// Update the current head to the new head
-			_pending_changes_head = context;
+		// Replace any schedule the component had and send it to sleep
+		const auto ticket = StartTimer( component, num_frames );
+		SetActive( component, false );
+		_timers.Schedule( component._context, ticket, num_frames );
+	}
+
+	/**
+	*	Puts the component to sleep and wakes it up after the given number of frames.
+	*
+	*	The component is put to sleep at the end of the frame and woken up by the late update of the frame the timer is due on, 
+	*	so it is first updated again the frame after. Nothing happens if the component is awake when the timer comes due, 
+	*	has been deleted or has been given a new schedule. Waiting for no frames cancels the timer and wakes the component.
+	*
+	*	@param component the component to put to sleep
+	*	@param num_frames the number of frames to sleep for
+	*/
+	inline void WakeAfter( const ComponentReference<ComponentType> &component, uint32_t num_frames )
+	{
+		// There is nothing to wait for
+		if ( num_frames == 0 )
+		{
+			WakeAndCancelTimer( component );
+			return;
 		}
 
-		// Mark component for pending changes
-		context->MarkActiveStateChange( new_active );
+		// Replace any schedule the component had and send it to sleep
+		const auto ticket = StartTimer( component, 0 );
+		SetActive( component, false );
+		_timers.Schedule( component._context, ticket, num_frames );
 	}
 
 	/**
-	*	Sets the component to be deleted. Changes will be applied at the end of the frame.
+	*	Sets the component to be deleted. Changes will be applied at the end of the frame. Thread safe.
 	*
 	*	@param component the component to delete
 	*/
@@ -184,190 +520,1897 @@ public:
 		if ( !component.IsValid( ) )
 			throw std::runtime_error( "Component reference was invalid." );
 
-		// Extract context from reference
-		auto context = component._context;
-
 		// Ensure control block actually belongs to this pool
-		if ( !_control_block_pool.IsPointerValid( context ) )
+		if ( component._locator != &_locator )
 			throw std::runtime_error( "Tried to delete component that did not belong to this component pool." );
 
-		// Add component to the pending changes list (if we haven't done so already)
-		if ( !context->IsPendingChanges( ) )
+		// Mark component for pending changes and add it to the pending changes list (if nobody has done so already)
+		if ( ControlBlock( component._context ).MarkForDeletion( ) )
+			PushPendingChanges( component._context );
+	}
+
+	/**
+	*	Sets several components to be deleted. Changes will be applied at the end of the frame. Thread safe.
+	*
+	*	Every reference is checked before any component is marked, and the marked components join the pending 
+	*	changes list in one go.
+	*
+	*	@param components the components to delete
+	*	@param num_components the number of components
+	*/
+	inline void DeleteMany( const ComponentReference<ComponentType> *components, size_t num_components )
+	{
+		// Check all of the given references before changing anything
+		for ( size_t i = 0; i < num_components; i++ )
 		{
-			// Point the new head to the current head
-			context->_next = _pending_changes_head;
+			if ( !components [ i ].IsValid( ) )
+				throw std::runtime_error( "Component reference was invalid." );
+
+			if ( components [ i ]._locator != &_locator )
+				throw std::runtime_error( "Tried to delete component that did not belong to this component pool." );
+		}
 
-			// Update the current head to the new head
-			_pending_changes_head = context;
+		// Mark the components and chain those that were not already pending changes
+		auto first = ComponentReferenceControlBlock::NULL_INDEX;
+		auto last = ComponentReferenceControlBlock::NULL_INDEX;
+		for ( size_t i = 0; i < num_components; i++ )
+		{
+			const auto control_block = components [ i ]._context;
+			if ( !ControlBlock( control_block ).MarkForDeletion( ) )
+				continue;
+
+			ControlBlock( control_block )._next = first;
+			first = control_block;
+			if ( last == ComponentReferenceControlBlock::NULL_INDEX )
+				last = control_block;
 		}
 
-		// Mark component for pending changes
-		context->MarkForDeletion( );
+		// Add the chain to the pending changes list
+		if ( first != ComponentReferenceControlBlock::NULL_INDEX )
+			PushPendingChanges( first, last );
 	}
 
 	/**
-	*	Applies pending changes to the component pool. 
+	*	Gets a field of a component kept in structure of arrays storage (see SoAComponentPoolTraits).
 	*
-	*	It is assumed at this stage we cannot invalidate any cached component pointers.
-	*	EG: A this pointer in a method call. 
+	*	The returned reference is invalidated by the next LateUpdate.
+	*
+	*	@param component the component to get the field of
+	*	@returns the field of the component
 	*/
-	inline void LateUpdate()
+	template <size_t FIELD, typename Storage = StorageType>
+	inline typename Storage::template FieldType<FIELD>::Type& GetField( const ComponentReference<ComponentType> &component )
 	{
-		// For every element of the pending changes list
-		while ( _pending_changes_head)
-		{
-			// Pop item from the list
-			auto const control = _pending_changes_head;
-
-			// Advance the head of the list
-			_pending_changes_head = _pending_changes_head->_next;
+		// Check if the given reference is valid
+		if ( !component.IsValid( ) )
+			throw std::runtime_error( "Component reference was invalid." );
 
-			/**
-			*	Pending changes have an ordering. 
-			*
-			*	1. Deletion (Dominates other changes)
-			*	2. Active State Changes
-			*/
-			if ( control->IsPendingDeletion( ) )
-			{
-				// Delete the component
-				DeleteInternal( *control );
+		// Ensure control block actually belongs to this pool
+		if ( component._locator != &_locator )
+			throw std::runtime_error( "Tried to get field of component that did not belong to this component pool." );
 
-				// Clean up the control block now that the component has been removed
-				_control_block_pool.Destroy( control );
+		// Extract context from reference
+		const auto &context = ControlBlock( component._context );
 
-				// Reclaim the control block
-				_control_block_pool.Deallocate( control, 1 );
-			}
-			else if (control->IsPendingActiveStateChange())
-			{
-				// Apply pending active state change
-				SetActiveInternal(*control, control->GetPendingActiveStateChange());
+		// Deferred components have no fields until the next late update
+		if ( context.IsPendingCreation( ) )
+			throw std::runtime_error( "Tried to get field of component that has not been created yet." );
 
-				// Clear any pending changes flags
-				control->ClearPendingChanges( );
-			}
-		}
+		return _components.template Field<FIELD>( context._index );
 	}
 
-private:
-
 	/**
-	*	Delete the component.
+	*	Checks if the component reference was handed out by this pool. Thread safe.
 	*/
-	inline void DeleteInternal( ComponentReferenceControlBlock &context )
+	inline bool Owns( const ComponentReference<ComponentType> &component ) const
 	{
-		// Make sure the component is active so we can move it to the end for deletion
-		SetActiveInternal( context, true );
+		return component._locator == &_locator;
+	}
 
-		// Get the typed component pointer
-		const auto *component = static_cast< ComponentType* >( context._component );
+	/**
+	*	Gets the compact handle for a component.
+	*
+	*	@param component the component to get the handle of
+	*	@returns the handle for the component, which resolves through this pool only
+	*/
+	inline ComponentHandle<ComponentType> GetHandle( const ComponentReference<ComponentType> &component )
+	{
+		// Check if the given reference is valid
+		if ( !component.IsValid( ) )
+			throw std::runtime_error( "Component reference was invalid." );
 
-		// Get the index of the component in the awake block
-		const auto loc_index = component - std::addressof( _components [ 0 ] );
+		// Ensure control block actually belongs to this pool
+		if ( component._locator != &_locator )
+			throw std::runtime_error( "Tried to get handle of component that did not belong to this component pool." );
 
-		// Get the index of the last component in the awake block
-		const auto target_index = Count( ) - 1;
+		return ComponentHandle<ComponentType>( component._context, component._control_block_tag );
+	}
 
-		// Move the component to the end of the awake block
-		SwapComponents( loc_index, target_index );
+	/**
+	*	Gets a component reference back from a handle made by this pool, so the component can be changed through it.
+	*
+	*	Only reads the control block of the handle, so may be called while components are updating. Handles made by
+	*	other pools must not be passed in.
+	*
+	*	@param handle the handle to get the reference for
+	*	@returns the reference to the component, or a null reference if the handle is null or the component is gone
+	*/
+	inline ComponentReference<ComponentType> GetReference( const ComponentHandle<ComponentType> &handle ) const
+	{
+		// Null handles and slots past the control blocks never name a component
+		if ( handle.IsNull( ) || handle._slot >= _control_block_pool.Capacity( ) )
+			return ComponentReference<ComponentType>( );
 
-		// Call destructor on the component
-		_components [ target_index ].~ComponentType( );
+		// Stale handles get a null reference rather than one to whatever reuses the control block
+		if ( ControlBlock( handle._slot ).GetGarbageTag( ) != handle._generation )
+			return ComponentReference<ComponentType>( );
 
-		// We now have one less active component
-		_num_active_components--;
+		return ComponentReference<ComponentType>( &_locator, handle._slot );
 	}
 
 	/**
-	*	Sets the active state of the component.
+	*	Resolves a handle made by this pool to its component.
+	*
+	*	Only reads the control block of the handle, so may be called while components are updating. The returned pointer
+	*	is invalidated by the next LateUpdate. Handles made by other pools must not be passed in.
+	*
+	*	@param handle the handle to resolve
+	*	@returns the component, or null if the component is gone, has not been created yet or the handle is null
 	*/
-	inline void SetActiveInternal(ComponentReferenceControlBlock &context, const bool new_active)
+	inline ComponentType* Resolve( const ComponentHandle<ComponentType> &handle ) const
 	{
-		// If component active state is already in desired state, do nothing
-		if (new_active == context.IsComponentActive())
-			return;
+		// Null handles and slots past the control blocks never name a component
+		if ( handle.IsNull( ) || handle._slot >= _control_block_pool.Capacity( ) )
+			return nullptr;
 
-		// Get the typed component pointer
-		const auto *component = static_cast<ComponentType*>(context._component);
+		const auto &control = ControlBlock( handle._slot );
+		if ( control.GetGarbageTag( ) != handle._generation )
+			return nullptr;
 
-		// Are we waking the component up?
-		if (new_active)
-		{
-			// Get the index of the component in the sleeping block
-			const auto loc_index = component - std::addressof( _components [ 0 ] );
-
-			// Get the index of the last component in the sleeping block
-			const auto target_index = _num_sleeping_components - 1;
+		return _locator.GetComponent( control._index );
+	}
 
-			// Move the component to the end of the sleeping block
-			SwapComponents( loc_index, target_index );
+	/**
+	*	Resolves a span of handles made by this pool to their components.
+	*
+	*	Control blocks are prefetched two prefetch distances ahead and components one distance ahead, so both are 
+	*	usually in cache by the time their handle is resolved.
+	*
+	*	@param handles the handles to resolve
+	*	@param count the number of handles
+	*	@param components receives the component for each handle, or null (see Resolve)
+	*/
+	inline void Resolve( const ComponentHandle<ComponentType> *handles, size_t count, ComponentType **components ) const
+	{
+		// Hoist constants
+		const size_t distance = Traits::PREFETCH_DISTANCE;
 
-			// Update the counters
-			_num_sleeping_components--;
-			_num_active_components++;
+		for ( size_t i = 0; i < count; i++ )
+		{
+			if ( i + 2 * distance < count )
+				PrefetchControlBlock( handles [ i + 2 * distance ]._slot );
+			if ( i + distance < count )
+				PrefetchComponent( handles [ i + distance ]._slot );
 
+			components [ i ] = Resolve( handles [ i ] );
 		}
-		// Are we putting the component to sleep?
-		else
-		{
-			// Get the index of the component in the active block
-			const auto loc_index = component - std::addressof( _components [ _num_sleeping_components ] );
+	}
+
+	/**
+	*	Resolves a span of references into this pool to their components, prefetching ahead like resolving handles does.
+	*
+	*	Only reads the control blocks of the references, so may be called while components are updating. The returned 
+	*	pointers are invalidated by the next LateUpdate.
+	*
+	*	@param references the references to resolve
+	*	@param count the number of references
+	*	@param components receives the component for each reference, or null if the reference is null or no longer valid 
+	*	or the component has not been created yet
+	*/
+	inline void ResolveAll( const ComponentReference<ComponentType> *references, size_t count, ComponentType **components ) const
+	{
+		// Hoist constants
+		const size_t distance = Traits::PREFETCH_DISTANCE;
 
-			// Get the index of the first component in the active block
-			const auto target_index = _num_sleeping_components;
+		for ( size_t i = 0; i < count; i++ )
+		{
+			// Only prefetch references into this pool, others are rejected below
+			if ( i + 2 * distance < count && references [ i + 2 * distance ]._locator == &_locator )
+				PrefetchControlBlock( references [ i + 2 * distance ]._context );
+			if ( i + distance < count && references [ i + distance ]._locator == &_locator )
+				PrefetchComponent( references [ i + distance ]._context );
+
+			const auto &reference = references [ i ];
+			if ( !reference.IsValid( ) )
+			{
+				components [ i ] = nullptr;
+				continue;
+			}
 
-			// Move the component to the beginning of the active block
-			SwapComponents( loc_index, target_index );
+			// Ensure control block actually belongs to this pool
+			if ( reference._locator != &_locator )
+				throw std::runtime_error( "Tried to resolve component that did not belong to this component pool." );
 
-			// Update the counters
-			_num_sleeping_components++;
-			_num_active_components--;
+			components [ i ] = _locator.GetComponent( ControlBlock( reference._context )._index );
 		}
-
-		// Set new active flag for component
-		context.SetComponentActive(new_active);
 	}
 
-
 	/**
-	*	Swaps two components in memory and updates the control table.
+	*	Calls fn( handle, component ) for every component, sleeping components first, in the order they lie in the pool.
+	*
+	*	The component is null if the pool does not store component objects, as with Resolve. Must not be called while 
+	*	components are updating. EG: To build an index over a pool that already holds components.
+	*
+	*	@param fn the function to call as fn( const ComponentHandle<ComponentType>&, const ComponentType* )
 	*/
-	inline void SwapComponents( size_t loc_index, size_t target_index )
+	template <typename Function>
+	inline void ForEach( Function fn ) const
 	{
-		// Ensure we are actually moving the component
-		if ( loc_index != target_index )
+		// Hoist constants
+		const auto count = Count( );
+
+		for ( size_t i = 0; i < count; i++ )
 		{
-			// Swap components and control table entries
-			std::swap( _components [ loc_index ], _components [ target_index ] );
-			std::swap( _control_table [ loc_index ]->_component, _control_table [ target_index ]->_component );
-			std::swap( _control_table [ loc_index ], _control_table [ target_index ] );
+			const auto control_block = _control_table [ i ];
+			fn( ComponentHandle<ComponentType>( control_block, ControlBlock( control_block ).GetGarbageTag( ) ), static_cast< const ComponentType* >( _locator.GetComponent( static_cast< IndexType >( i ) ) ) );
 		}
 	}
 
 	/**
-	*	Gets the number of components in the component pool.
+	*	Calls fn( handle, component ) for every active component marked as changed, in the order of the active block.
+	*
+	*	Needs a pool that tracks changes (see ChangeTrackingComponentPoolTraits). Components are marked when they are 
+	*	created, restored from a snapshot or mapped file, got through a non const ComponentReference or marked through 
+	*	ComponentReference::MarkDirty. Marks move with their components, so sleeping components keep theirs until they 
+	*	wake. The component is null if the pool does not store component objects, as with Resolve. Clean components 
+	*	are skipped eight at a time, so the walk costs one read per eight clean components plus one call per change.
+	*
+	*	Must not be called while components are updating.
+	*
+	*	@param fn the function to call as fn( const ComponentHandle<ComponentType>&, const ComponentType* )
 	*/
-	inline size_t Count( ) const
+	template <typename Function>
+	inline void ForEachDirty( Function fn ) const
 	{
-		return _num_active_components + _num_sleeping_components;
-	}
+		static_assert( TRACK_CHANGES, "Only component pools that track changes have dirty components." );
 
-	/**< The control block object pool. */
-	CRCBPool<MAX_COMPONENTS> _control_block_pool;
+		// Hoist constants
+		const auto begin = _num_sleeping_components;
+		auto index = begin;
 
-	/**< The component object pool. */
-	ComponentType _components [ MAX_COMPONENTS ];
+		_dirty.ForEachSpan( begin, Count( ), [ this, &fn, &index ] ( const uint8_t *marks, size_t count )
+		{
+			for ( size_t i = 0; i < count; i++ )
+			{
+				// Skip runs of eight clean components with one read
+				if ( i + 8 <= count )
+				{
+					uint64_t run;
+					std::memcpy( &run, marks + i, sizeof( run ) );
+					if ( run == 0 )
+					{
+						i += 7;
+						continue;
+					}
+				}
+
+				if ( !marks [ i ] )
+					continue;
+
+				const auto slot = index + i;
+				const auto control_block = _control_table [ slot ];
+				fn( ComponentHandle<ComponentType>( control_block, ControlBlock( control_block ).GetGarbageTag( ) ), static_cast< const ComponentType* >( _locator.GetComponent( static_cast< IndexType >( slot ) ) ) );
+			}
 
-	/**< The control block table that maps component locations to reference control blocks. */
-	ComponentReferenceControlBlock* _control_table [ MAX_COMPONENTS ];
+			index += count;
+		} );
+	}
 
-	/**< The head of the pending changes list. */
-	ComponentReferenceControlBlock *_pending_changes_head;
+	/**
+	*	Clears the dirty marks of the active components, EG: once their changes have been sent.
+	*
+	*	Sleeping components keep their marks, as ForEachDirty does not visit them. Must not be called while components are updating.
+	*/
+	inline void ClearDirty( )
+	{
+		static_assert( TRACK_CHANGES, "Only component pools that track changes have dirty components." );
 
-	/**< The number of active components in the component pool. */
-	size_t _num_active_components;
+		SetDirty( _num_sleeping_components, Count( ), false );
+	}
 
-	/**< The number of sleeping components in the component pool. */
-	size_t _num_sleeping_components;
+	/**
+	*	Reorders the active block by a key of each component, so components with nearby keys end up nearby in memory.
+	*
+	*	The key function is called once per active component as key( const ComponentType& ) and the keys are compared with <.
+	*	Components with equal keys keep their relative order. EG: Sort by owner entity or by Morton code of the spatial cell.
+	*
+	*	Must not be called while components are updating. Needs storage that keeps whole components (see ComponentStorage).
+	*	It is assumed at this stage we cannot invalidate any cached component pointers, as with LateUpdate.
+	*
+	*	@param key the function giving the sort key of a component
+	*/
+	template <typename KeyFunction>
+	inline void Sort( KeyFunction key )
+	{
+		PlanSortOrder( key );
+		ApplySortOrder( std::numeric_limits<size_t>::max( ) );
+	}
+
+	/**
+	*	Reorders the active block by a key of each component a bit at a time, spreading the work of Sort over several frames.
+	*
+	*	The first call gathers the sorted order, calling the key function once per active component. Every call then swaps at most 
+	*	budget components into place. Changes applied by LateUpdate discard the gathered order so the next call starts over, 
+	*	while components created in the meantime wait for the next pass. Pass the same key function until the pass completes.
+	*
+	*	@param key the function giving the sort key of a component
+	*	@param budget the maximum number of components to swap in this call
+	*	@returns true once the pass has completed and the active block is in key order
+	*/
+	template <typename KeyFunction>
+	inline bool Defragment( KeyFunction key, size_t budget )
+	{
+		// Start a new pass if there is none underway
+		if ( _sort_order.empty( ) )
+			PlanSortOrder( key );
+
+		return ApplySortOrder( budget );
+	}
+
+	/**
+	*	Writes a snapshot of the whole pool (see ComponentSerialization.h). Needs trivially copyable components or fields.
+	*
+	*	The components are written as a few contiguous blocks along with the sleeping and active split and the garbage 
+	*	tag of every control block. Changes recorded since the last LateUpdate and deferred creates are not part of the snapshot.
+	*	Must not be called while components are updating.
+	*
+	*	@param writer the writer to write the snapshot to
+	*/
+	template <typename Writer>
+	inline void Serialize( Writer &writer ) const
+	{
+		// Control blocks may be handed out concurrently by CreateDeferred
+		std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+
+		// Hoist constants
+		const auto count = Count( );
+		const auto num_control_blocks = _control_block_pool.Capacity( );
+
+		// Write the header
+		WriteValue( writer, ComponentPoolSnapshot::MAGIC );
+		WriteValue( writer, ComponentPoolSnapshot::VERSION );
+		WriteValue( writer, static_cast< uint64_t >( sizeof( ComponentType ) ) );
+		WriteValue( writer, static_cast< uint64_t >( count ) );
+		WriteValue( writer, static_cast< uint64_t >( _num_sleeping_components ) );
+		WriteValue( writer, static_cast< uint64_t >( num_control_blocks ) );
+
+		// Write the tags of all control blocks so stale references stay stale once restored
+		std::vector<uint64_t> tags( num_control_blocks );
+		for ( size_t i = 0; i < num_control_blocks; i++ )
+			tags [ i ] = ControlBlock( static_cast< IndexType >( i ) ).GetFullGarbageTag( );
+		WriteValues( writer, tags.data( ), tags.size( ) );
+
+		// Write which control block each component belongs to
+		_control_table.ForEachSpan( 0, count, [ &writer ] ( const IndexType *control_blocks, size_t num_entries )
+		{
+			WriteValues( writer, control_blocks, num_entries );
+		} );
+
+		// Write the components
+		_components.Write( writer, count );
+	}
+
+	/**
+	*	Replaces the contents of the pool with a snapshot written by Serialize.
+	*
+	*	Components are restored with the control blocks they had, so references and handles to components that were 
+	*	alive in the snapshot resolve to the restored components, in this pool or in the pool the snapshot was taken from if
+	*	this is that pool. References to every other component are invalidated, although references made after the snapshot 
+	*	may become valid again once their control block is reused and should be dropped. Pending changes and deferred creates 
+	*	are discarded. The snapshot is checked before the pool is touched, but if reading the components fails the pool is left empty.
+	*	Must be called from the thread that owns the pool while no other thread records changes, like LateUpdate.
+	*
+	*	@param reader the reader to read the snapshot from
+	*/
+	template <typename Reader>
+	inline void Deserialize( Reader &reader )
+	{
+		// Read and check the header
+		uint32_t magic, version;
+		uint64_t component_size, snapshot_count, snapshot_num_sleeping, snapshot_num_control_blocks;
+		ReadValue( reader, magic );
+		ReadValue( reader, version );
+		ReadValue( reader, component_size );
+		ReadValue( reader, snapshot_count );
+		ReadValue( reader, snapshot_num_sleeping );
+		ReadValue( reader, snapshot_num_control_blocks );
+
+		if ( magic != ComponentPoolSnapshot::MAGIC || version != ComponentPoolSnapshot::VERSION )
+			throw std::runtime_error( "Snapshot was not a component pool snapshot of a supported version." );
+		if ( component_size != sizeof( ComponentType ) )
+			throw std::runtime_error( "Snapshot was taken of a different component type." );
+		if ( snapshot_count > _max_components || snapshot_num_sleeping > snapshot_count || snapshot_count > snapshot_num_control_blocks 
+			|| snapshot_num_control_blocks >= ComponentReferenceControlBlock::NULL_INDEX )
+			throw std::runtime_error( "Snapshot does not fit in the component pool." );
+
+		const auto count = static_cast< size_t >( snapshot_count );
+		const auto num_sleeping = static_cast< size_t >( snapshot_num_sleeping );
+		const auto num_control_blocks = static_cast< size_t >( snapshot_num_control_blocks );
+
+		// Read the control block tags and the control table (may throw)
+		std::vector<uint64_t> tags( num_control_blocks );
+		ReadValues( reader, tags.data( ), tags.size( ) );
+		std::vector<IndexType> control_table( count );
+		ReadValues( reader, control_table.data( ), control_table.size( ) );
+
+		// Map control blocks back to their components, which also checks that no two components share one
+		std::vector<IndexType> component_indices( num_control_blocks, static_cast< IndexType >( ComponentReferenceControlBlock::NULL_INDEX ) );
+		for ( size_t i = 0; i < count; i++ )
+		{
+			const auto control_block = control_table [ i ];
+			if ( control_block >= num_control_blocks || component_indices [ control_block ] != ComponentReferenceControlBlock::NULL_INDEX )
+				throw std::runtime_error( "Snapshot control table was corrupt." );
+
+			component_indices [ control_block ] = static_cast< IndexType >( i );
+		}
+
+		// Make sure we have storage for the snapshot (may throw)
+		_components.Reserve( count );
+		_control_table.Reserve( count );
+		ReserveDirty( count );
+		{
+			std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+			_control_block_pool.Reserve( num_control_blocks );
+			_deferred_creates.clear( );
+		}
+
+		// Drop the current contents, the control blocks are all overwritten below
+		_components.DestroyRange( 0, Count( ) );
+		_num_active_components = 0;
+		_num_sleeping_components = 0;
+		_pending_changes_head = ComponentReferenceControlBlock::NULL_INDEX;
+		_carried_changes.clear( );
+		_sort_order.clear( );
+		_timers.Clear( );
+		_schedules.clear( );
+		_events.Clear( );
+
+		// Read the components into the uninitialized slots (may throw)
+		try
+		{
+			_components.Read( reader, count );
+		}
+		catch ( ... )
+		{
+			// Leave the pool empty with every reference invalidated
+			RestoreControlBlocks( std::vector<IndexType>( ), tags, 0 );
+
+			// Rethrow read exception
+			throw;
+		}
+
+		// Point the control blocks and the control table at the restored components
+		RestoreControlBlocks( component_indices, tags, num_sleeping );
+		for ( size_t i = 0; i < count; i++ )
+			_control_table [ i ] = control_table [ i ];
+
+		// Every restored component counts as changed
+		SetDirty( 0, count, true );
+
+		// Update the counters
+		_num_sleeping_components = num_sleeping;
+		_num_active_components = count - num_sleeping;
+		COMPONENT_POOL_STAT( RecordHighWaterMarks( ) );
+		UpdateMappedHeader( );
+		COMPONENT_POOL_VALIDATE( Validate( ) );
+	}
+
+	/**
+	*	Sets the publisher every LateUpdate publishes a copy of the active block to once all changes are applied.
+	*
+	*	Readers on other threads can then acquire the latest copy from the publisher without locking, and hold on to it 
+	*	while the pool keeps updating and moving components (see ComponentPublisher). Needs copyable components kept in 
+	*	ComponentStorage. The publisher must outlive the pool or be unset first.
+	*
+	*	@param publisher the publisher to publish to, null to stop publishing
+	*/
+	inline void SetPublisher( ComponentPublisher<ComponentType> *publisher )
+	{
+		static_assert( IS_PUBLISHABLE, "Only copyable components kept in ComponentStorage can be published." );
+
+		_publisher = publisher;
+	}
+
+	/**
+	*	Sets the listener late updates deliver the lifecycle events of components to (see ComponentPoolListener).
+	*
+	*	Events are only gathered while a listener is set. The listener must outlive the pool or be unset first.
+	*
+	*	@param listener the listener to notify, null to stop gathering events
+	*/
+	inline void SetListener( ComponentPoolListener<ComponentType> *listener )
+	{
+		_listener = listener;
+
+		// Drop events gathered for the previous listener
+		_events.Clear( );
+	}
+
+#if COMPONENT_POOL_STATS
+
+	/**
+	*	Gets the counters of the pool (see ComponentPoolStats). Only available when COMPONENT_POOL_STATS is set.
+	*/
+	inline ComponentPoolStats GetStats( ) const
+	{
+		// Control blocks may be allocated concurrently by CreateDeferred
+		std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+
+		auto stats = _stats;
+		stats._num_active_components = _num_active_components;
+		stats._num_sleeping_components = _num_sleeping_components;
+		stats._num_control_blocks = _control_block_pool.Size( );
+		stats._control_block_capacity = _control_block_pool.Capacity( );
+		stats._num_timers = _timers.Size( );
+
+		return stats;
+	}
+
+	/**
+	*	Clears the totals and high water marks of the pool.
+	*/
+	inline void ResetStats( )
+	{
+		std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+		_stats = ComponentPoolStats( );
+	}
+
+#endif
+
+	/**
+	*	Checks the invariants of the pool, throwing std::logic_error if any is broken.
+	*
+	*	Every slot must hold a created component whose control block points back at the slot, the sleeping block must 
+	*	hold exactly the sleeping components, every component must have a control block and the pending changes list 
+	*	must be a finite chain of control blocks with pending changes. Walks the whole pool, so it is meant for debugging. 
+	*	Called by LateUpdate and Deserialize when COMPONENT_POOL_VALIDATION is set (see ComponentValidation.h).
+	*/
+	inline void Validate( ) const
+	{
+		// Hoist constants
+		const auto count = Count( );
+		const auto capacity = _control_block_pool.Capacity( );
+
+		// Check the control table and the control blocks point at each other
+		for ( size_t i = 0; i < count; i++ )
+		{
+			const auto control_block = _control_table [ i ];
+			if ( control_block >= capacity )
+				throw std::logic_error( "Control table entry does not name a control block." );
+
+			const auto &context = ControlBlock( control_block );
+			if ( context.GetComponentIndex( ) != i || context.IsPendingCreation( ) )
+				throw std::logic_error( "Control block does not point back at its control table entry." );
+
+			// Sleeping components come first, active components after
+			if ( context.IsComponentActive( ) != ( i >= _num_sleeping_components ) )
+				throw std::logic_error( "Component active state does not match the block it is in." );
+		}
+
+		// Every component and every deferred create holds a control block, concurrent pools may be allocating more
+		{
+			std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+			const auto num_control_blocks = count + _deferred_creates.size( );
+			if ( ControlBlockPoolType::CONCURRENT ? _control_block_pool.Size( ) < num_control_blocks : _control_block_pool.Size( ) != num_control_blocks )
+				throw std::logic_error( "Control block count does not match the component count." );
+		}
+
+		// Walk the pending changes list, which cannot be longer than the control block pool without a cycle
+		size_t length = 0;
+		for ( auto control_block = _pending_changes_head.load( ); control_block != ComponentReferenceControlBlock::NULL_INDEX; control_block = ControlBlock( control_block )._next )
+		{
+			if ( control_block >= capacity || ++length > capacity )
+				throw std::logic_error( "Pending changes list is corrupt." );
+
+			const auto &context = ControlBlock( control_block );
+			if ( !context.IsPendingChanges( ) || ( !context.IsPendingCreation( ) && context.GetComponentIndex( ) >= count ) )
+				throw std::logic_error( "Pending changes list holds a control block without pending changes." );
+		}
+	}
+
+	/**
+	*	Applies pending changes to the component pool. 
+	*
+	*	Deferred creates are applied first in the order they were recorded. All other changes are then applied 
+	*	as one batch in component order, so the result does not depend on which threads recorded the changes.
+	*
+	*	It is assumed at this stage we cannot invalidate any cached component pointers.
+	*	EG: A this pointer in a method call. 
+	*/
+	inline void LateUpdate( )
+	{
+		LateUpdate( std::numeric_limits<size_t>::max( ) );
+	}
+
+	/**
+	*	Applies pending changes to the component pool, up to the given number of changes.
+	*
+	*	Deferred creates, wakes and sleeps each count as one change and are applied in the order they were recorded 
+	*	until the budget runs out. The rest are carried over and applied ahead of newer changes by later late updates. 
+	*	Until then, components waiting on a create resolve to null, components waiting to wake stay asleep and 
+	*	components waiting to sleep keep updating.
+	*
+	*	Deletes are never carried over, so a component deleted during a frame never updates after its late update. 
+	*	They still count against the budget, and until they are applied references report them through 
+	*	ComponentReference::IsPendingDeletion. Changes recorded while a change is carried over combine with it 
+	*	as they would within one frame.
+	*
+	*	@param budget the number of changes to apply
+	*	@returns true if every pending change was applied, false if some were carried over
+	*/
+	inline bool LateUpdate( size_t budget )
+	{
+		COMPONENT_POOL_PROFILE_SCOPE( "ComponentPool::LateUpdate" );
+		COMPONENT_POOL_STAT( _stats._num_late_updates++ );
+
+		// Construct components created from other threads, which may queue up further changes for them
+		const auto create_exception = ApplyDeferredCreates( budget );
+		COMPONENT_POOL_STAT( RecordHighWaterMarks( ) );
+		COMPONENT_POOL_STAT( if ( ControlBlockPoolType::CONCURRENT ) RecordControlBlockHighWaterMark( ) );
+
+		// Gather the pending changes list, no other thread may record changes during a late update
+		_pending_changes.clear( );
+		for ( auto control = _pending_changes_head.load( ); control != ComponentReferenceControlBlock::NULL_INDEX; control = ControlBlock( control )._next )
+			_pending_changes.push_back( &ControlBlock( control ) );
+
+		// Take new changes in component order, so the result does not depend on which threads recorded them
+		SortChanges( _pending_changes );
+
+		// Changes carried over from earlier late updates go first, they are still pending so nobody pushed them again (may throw)
+		_pending_changes.insert( _pending_changes.begin( ), _carried_changes.begin( ), _carried_changes.end( ) );
+		COMPONENT_POOL_STAT( _stats._num_pending_changes = _pending_changes.size( ) );
+		COMPONENT_POOL_STAT( _stats._max_pending_changes = std::max( _stats._max_pending_changes, _pending_changes.size( ) ) );
+
+		// Make sure sorting the changes cannot fail halfway through the batch (may throw)
+		_pending_deletes.reserve( _pending_changes.size( ) );
+		_pending_wakes.reserve( _pending_changes.size( ) );
+		_pending_sleeps.reserve( _pending_changes.size( ) );
+		_deleted_indices.reserve( _pending_changes.size( ) );
+		_carried_changes.reserve( _pending_changes.size( ) );
+		if ( _listener )
+			_events.Reserve( _pending_changes.size( ) );
+
+		_pending_changes_head = ComponentReferenceControlBlock::NULL_INDEX;
+		_carried_changes.clear( );
+
+		/**
+		*	Pending changes have an ordering. 
+		*
+		*	1. Deletion (Dominates other changes)
+		*	2. Active State Changes
+		*/
+		_pending_deletes.clear( );
+		_pending_wakes.clear( );
+		_pending_sleeps.clear( );
+		for ( auto *const control : _pending_changes )
+		{
+			if ( control->IsPendingDeletion( ) )
+			{
+				_pending_deletes.push_back( control );
+				if ( budget > 0 )
+					budget--;
+			}
+			else if ( control->IsPendingActiveStateChange( ) && control->GetPendingActiveStateChange( ) != control->IsComponentActive( ) )
+			{
+				// Leave the change for a later late update once the budget runs out
+				if ( budget == 0 )
+					_carried_changes.push_back( control );
+				else if ( control->GetPendingActiveStateChange( ) )
+					_pending_wakes.push_back( control );
+				else
+					_pending_sleeps.push_back( control );
+
+				if ( budget > 0 )
+					budget--;
+			}
+			else
+			{
+				// Component is already in the desired state
+				control->ClearPendingChanges( );
+			}
+		}
+
+		// Carried changes come first, so put the deletes back in component order
+		SortChanges( _pending_deletes );
+		COMPONENT_POOL_STAT( _stats._num_carried_changes = _carried_changes.size( ) + NumDeferredCreates( ) );
+
+		// Apply the batch
+		ApplyDeletes( );
+		ApplyWakes( );
+		ApplySleeps( );
+		COMPONENT_POOL_VALIDATE( Validate( ) );
+
+		// Keep a mapped file in step with the applied changes
+		UpdateMappedHeader( );
+
+		// Hand readers a copy of the settled active block (may throw)
+		if ( _publisher )
+			Publish( std::integral_constant<bool, IS_PUBLISHABLE>( ) );
+
+		// Tell the listener what changed this frame (may throw)
+		if ( _listener )
+			NotifyListener( );
+
+		// Report any deferred create that could not be constructed
+		if ( create_exception )
+			std::rethrow_exception( create_exception );
+
+		return _carried_changes.empty( ) && NumDeferredCreates( ) == 0;
+	}
+
+private:
+
+	/**
+	*	The schedule of a component started by SetUpdateInterval or WakeAfter.
+	*/
+	struct Schedule
+	{
+		/**< The garbage tag of the component control block when the schedule was started. */
+		uint32_t _tag;
+
+		/**< The ticket of the current timer of the component, older timers are stale. */
+		uint32_t _ticket;
+
+		/**< The number of frames between updates, zero if the component is to be woken instead. */
+		uint32_t _interval;
+
+		/**< The pool time the component was last updated at. */
+		double _last_update_time;
+	};
+
+	/**
+	*	The lifecycle events gathered for the listener.
+	*/
+	struct LifecycleEvents
+	{
+		/**
+		*	Makes room for the given number of further deletes, wakes and sleeps.
+		*/
+		inline void Reserve( size_t count )
+		{
+			_deleted.reserve( _deleted.size( ) + count );
+			_woken.reserve( _woken.size( ) + count );
+			_slept.reserve( _slept.size( ) + count );
+		}
+
+		/**
+		*	Drops all events, keeping their storage.
+		*/
+		inline void Clear( )
+		{
+			_created.clear( );
+			_deleted.clear( );
+			_woken.clear( );
+			_slept.clear( );
+		}
+
+		/**
+		*	Exchanges the events with another set of events.
+		*/
+		inline void Swap( LifecycleEvents &other )
+		{
+			_created.swap( other._created );
+			_deleted.swap( other._deleted );
+			_woken.swap( other._woken );
+			_slept.swap( other._slept );
+		}
+
+		/**< The components created. */
+		std::vector<ComponentHandle<ComponentType>> _created;
+
+		/**< The components deleted. */
+		std::vector<ComponentHandle<ComponentType>> _deleted;
+
+		/**< The components woken up. */
+		std::vector<ComponentHandle<ComponentType>> _woken;
+
+		/**< The components put to sleep. */
+		std::vector<ComponentHandle<ComponentType>> _slept;
+	};
+
+	/**
+	*	A component creation recorded by CreateDeferred.
+	*/
+	struct DeferredCreate
+	{
+		inline DeferredCreate( IndexType control_block, std::function<void( StorageType&, size_t )> &&construct )
+			: _control_block( control_block )
+			, _construct( std::move( construct ) )
+		{
+
+		}
+
+		/**< The control block handed out for the component. */
+		IndexType _control_block;
+
+		/**< Constructs the component in the given slot. */
+		std::function<void( StorageType&, size_t )> _construct;
+	};
+
+	/**
+	*	Gets the control block at the given index.
+	*/
+	inline ComponentReferenceControlBlock& ControlBlock( IndexType index ) const
+	{
+		return _control_block_pool [ index ];
+	}
+
+	/**
+	*	Hints that the control block at the given index will be used soon, unless the index is null or out of range.
+	*/
+	inline void PrefetchControlBlock( IndexType control_block ) const
+	{
+		// The null index is never in range either
+		if ( control_block < _control_block_pool.Capacity( ) )
+			COMPONENT_PREFETCH( &ControlBlock( control_block ) );
+	}
+
+	/**
+	*	Hints that the component of the control block at the given index will be used soon, unless either is missing.
+	*/
+	inline void PrefetchComponent( IndexType control_block ) const
+	{
+		// The null index is never in range either
+		if ( control_block >= _control_block_pool.Capacity( ) )
+			return;
+
+		const auto index = ControlBlock( control_block )._index;
+		if ( index != ComponentReferenceControlBlock::NULL_INDEX )
+			_components.Prefetch( index );
+	}
+
+	/**
+	*	Hints that the component of the gathered change one prefetch distance past the given position will be used soon.
+	*
+	*	@param changes the gathered changes being applied
+	*	@param position the position of the change being applied
+	*/
+	inline void PrefetchChange( const std::vector<ComponentReferenceControlBlock*> &changes, size_t position ) const
+	{
+		const auto ahead = position + Traits::PREFETCH_DISTANCE;
+		if ( ahead < changes.size( ) )
+			_components.Prefetch( changes [ ahead ]->_index );
+	}
+
+	/**
+	*	Takes the lock guarding the control block pool against concurrent CreateDeferred calls, unless the pool is concurrent itself.
+	*/
+	inline std::unique_lock<std::mutex> LockControlBlocks( ) const
+	{
+		std::unique_lock<std::mutex> lock( _deferred_creates_mutex, std::defer_lock );
+		if ( !ControlBlockPoolType::CONCURRENT )
+			lock.lock( );
+
+		return lock;
+	}
+
+	/**
+	*	Allocates a control block, guarding against concurrent CreateDeferred calls.
+	*/
+	inline IndexType AllocateControlBlock( )
+	{
+		auto lock = LockControlBlocks( );
+		const auto control_block = _control_block_pool.Allocate( 1 );
+		COMPONENT_POOL_STAT( if ( lock.owns_lock( ) ) RecordControlBlockHighWaterMark( ) );
+		return control_block;
+	}
+
+	/**
+	*	Returns a control block, guarding against concurrent CreateDeferred calls.
+	*/
+	inline void DeallocateControlBlock( IndexType control_block )
+	{
+		auto lock = LockControlBlocks( );
+		_control_block_pool.Deallocate( control_block, 1 );
+	}
+
+	/**
+	*	Overwrites every control block when restoring a snapshot and rebuilds the free list.
+	*
+	*	Control blocks of restored components get their snapshot tag back. All other control blocks move past both
+	*	their snapshot tag and their current tag, so no reference or handle to them stays valid.
+	*
+	*	@param component_indices the component of each control block in the snapshot, NULL_INDEX for free (missing entries are free)
+	*	@param tags the snapshot tag of each control block (missing entries are zero)
+	*	@param num_sleeping the number of sleeping components in the snapshot
+	*/
+	inline void RestoreControlBlocks( const std::vector<IndexType> &component_indices, const std::vector<uint64_t> &tags, size_t num_sleeping )
+	{
+		std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+
+		const auto num_control_blocks = _control_block_pool.Capacity( );
+		for ( size_t i = 0; i < num_control_blocks; i++ )
+		{
+			auto &control = ControlBlock( static_cast< IndexType >( i ) );
+			const IndexType index = i < component_indices.size( ) ? component_indices [ i ] : static_cast< IndexType >( ComponentReferenceControlBlock::NULL_INDEX );
+			const uint64_t tag = i < tags.size( ) ? tags [ i ] : 0;
+
+			if ( index != ComponentReferenceControlBlock::NULL_INDEX )
+				control.Restore( tag, index, index >= num_sleeping );
+			else
+				control.Restore( std::max( tag, control.GetFullGarbageTag( ) ) + 1, ComponentReferenceControlBlock::NULL_INDEX, false );
+		}
+
+		_control_block_pool.RelinkFreeList( [ this ] ( IndexType index ) { return ControlBlock( index )._index == ComponentReferenceControlBlock::NULL_INDEX; } );
+	}
+
+	/**
+	*	Writes a value of a snapshot.
+	*/
+	template <typename Writer, typename ValueType>
+	static inline void WriteValue( Writer &writer, const ValueType value )
+	{
+		writer.Write( std::addressof( value ), sizeof( ValueType ) );
+	}
+
+	/**
+	*	Writes an array of values of a snapshot.
+	*/
+	template <typename Writer, typename ValueType>
+	static inline void WriteValues( Writer &writer, const ValueType *values, size_t count )
+	{
+		if ( count )
+			writer.Write( values, count * sizeof( ValueType ) );
+	}
+
+	/**
+	*	Reads a value of a snapshot.
+	*/
+	template <typename Reader, typename ValueType>
+	static inline void ReadValue( Reader &reader, ValueType &value )
+	{
+		reader.Read( std::addressof( value ), sizeof( ValueType ) );
+	}
+
+	/**
+	*	Reads an array of values of a snapshot.
+	*/
+	template <typename Reader, typename ValueType>
+	static inline void ReadValues( Reader &reader, ValueType *values, size_t count )
+	{
+		if ( count )
+			reader.Read( values, count * sizeof( ValueType ) );
+	}
+
+	/**
+	*	The header at the start of a mapped file, followed by the control blocks, the control table and the component slots.
+	*/
+	struct MappedHeader
+	{
+		/**< Identifies mapped component pool files. */
+		static const uint32_t MAGIC = 0x4d504f43; // "COPM"
+
+		/**< The file layout version, bumped whenever the layout changes. */
+		static const uint32_t VERSION = 1;
+
+		uint32_t _magic;
+		uint32_t _version;
+		uint64_t _component_size;
+		uint64_t _component_alignment;
+		uint64_t _chunk_size;
+		uint64_t _num_chunks;
+		uint64_t _num_active_components;
+		uint64_t _num_sleeping_components;
+		uint64_t _num_control_blocks;
+		uint64_t _free_list_head;
+	};
+
+	/**
+	*	Rounds the offset up to the given power of two alignment.
+	*/
+	static inline size_t AlignMappedOffset( size_t offset, size_t alignment )
+	{
+		return ( offset + alignment - 1 ) & ~( alignment - 1 );
+	}
+
+	/**
+	*	Gets the offset of the control blocks in a mapped file.
+	*/
+	static inline size_t MappedControlBlocksOffset( size_t )
+	{
+		return AlignMappedOffset( sizeof( MappedHeader ), ChunkedArray<ComponentReferenceControlBlock, CHUNK_SIZE>::ALIGNMENT );
+	}
+
+	/**
+	*	Gets the offset of the control table in a mapped file with the given number of chunks.
+	*/
+	static inline size_t MappedControlTableOffset( size_t num_chunks )
+	{
+		return AlignMappedOffset( MappedControlBlocksOffset( num_chunks ) + num_chunks * CHUNK_SIZE * sizeof( ComponentReferenceControlBlock ), ChunkedArray<IndexType, CHUNK_SIZE>::ALIGNMENT );
+	}
+
+	/**
+	*	Gets the offset of the component slots in a mapped file with the given number of chunks.
+	*/
+	static inline size_t MappedComponentsOffset( size_t num_chunks )
+	{
+		return AlignMappedOffset( MappedControlTableOffset( num_chunks ) + num_chunks * CHUNK_SIZE * sizeof( IndexType ), ChunkedArray<ComponentType, CHUNK_SIZE>::ALIGNMENT );
+	}
+
+	/**
+	*	Gets the size of a mapped file with the given number of chunks.
+	*/
+	static inline size_t MappedSize( size_t num_chunks )
+	{
+		return MappedComponentsOffset( num_chunks ) + num_chunks * CHUNK_SIZE * sizeof( ComponentType );
+	}
+
+	/**
+	*	Maps the file and hands its chunks to the control block pool, the control table and the component storage.
+	*/
+	inline void MapStorage( ComponentMappedFile &file, size_t capacity )
+	{
+		// Control block indices must fit in an index, leaving out the null index
+		const size_t max_chunks = ( ComponentReferenceControlBlock::NULL_INDEX - 1 ) / CHUNK_SIZE;
+
+		const auto existing = file.GetOpenedSize( ) != 0;
+		size_t num_chunks;
+		MappedHeader *header;
+
+		if ( existing )
+		{
+			// Check the file holds a pool of this component type
+			if ( file.GetOpenedSize( ) < sizeof( MappedHeader ) )
+				throw std::runtime_error( "File was not a mapped component pool file." );
+
+			header = static_cast< MappedHeader* >( file.Map( file.GetOpenedSize( ) ) );
+			if ( header->_magic != MappedHeader::MAGIC || header->_version != MappedHeader::VERSION )
+				throw std::runtime_error( "File was not a mapped component pool file of a supported version." );
+			if ( header->_component_size != sizeof( ComponentType ) || header->_component_alignment != std::alignment_of<ComponentType>::value || header->_chunk_size != CHUNK_SIZE )
+				throw std::runtime_error( "Mapped component pool file was laid out for a different component type." );
+
+			num_chunks = static_cast< size_t >( header->_num_chunks );
+			const auto num_slots = num_chunks * CHUNK_SIZE;
+			if ( header->_num_chunks > max_chunks || MappedSize( num_chunks ) > file.GetOpenedSize( ) 
+				|| header->_num_active_components + header->_num_sleeping_components > num_slots || header->_num_control_blocks > num_slots
+				|| ( header->_free_list_head != ComponentReferenceControlBlock::NULL_INDEX && header->_free_list_head >= num_slots ) )
+				throw std::runtime_error( "Mapped component pool file was corrupt." );
+		}
+		else
+		{
+			// Lay out a new file
+			num_chunks = ( capacity + CHUNK_SIZE - 1 ) / CHUNK_SIZE;
+			if ( num_chunks == 0 || num_chunks > max_chunks )
+				throw std::runtime_error( "Mapped component pool capacity must be between one and the control block index limit." );
+
+			header = static_cast< MappedHeader* >( file.Map( MappedSize( num_chunks ) ) );
+			header->_magic = MappedHeader::MAGIC;
+			header->_version = MappedHeader::VERSION;
+			header->_component_size = sizeof( ComponentType );
+			header->_component_alignment = std::alignment_of<ComponentType>::value;
+			header->_chunk_size = CHUNK_SIZE;
+			header->_num_chunks = num_chunks;
+		}
+
+		// Hand every chunk over, fresh control blocks are set up and linked into the free list as they are adopted (may throw)
+		auto *const base = reinterpret_cast< unsigned char* >( header );
+		auto *const control_blocks = reinterpret_cast< ComponentReferenceControlBlock* >( base + MappedControlBlocksOffset( num_chunks ) );
+		auto *const control_table = reinterpret_cast< IndexType* >( base + MappedControlTableOffset( num_chunks ) );
+		auto *const components = reinterpret_cast< ComponentType* >( base + MappedComponentsOffset( num_chunks ) );
+		for ( size_t i = 0; i < num_chunks; i++ )
+		{
+			_control_block_pool.AdoptChunk( control_blocks + i * CHUNK_SIZE, !existing );
+			_control_table.AdoptChunk( control_table + i * CHUNK_SIZE );
+			_components.AdoptChunk( components + i * CHUNK_SIZE );
+		}
+		_control_block_pool.StopGrowing( );
+
+		// Pick up where the file left off
+		if ( existing )
+		{
+			_control_block_pool.RestoreFreeList( static_cast< IndexType >( header->_free_list_head ), static_cast< size_t >( header->_num_control_blocks ) );
+			_num_active_components = static_cast< size_t >( header->_num_active_components );
+			_num_sleeping_components = static_cast< size_t >( header->_num_sleeping_components );
+
+			// Changes still pending when the file was last used died with that pool, so drop them
+			const auto num_control_blocks = _control_block_pool.Capacity( );
+			for ( size_t i = 0; i < num_control_blocks; i++ )
+			{
+				const auto control_block = static_cast< IndexType >( i );
+				auto &control = ControlBlock( control_block );
+
+				// Reclaim the control blocks of creates that were never applied, invalidating any references to them
+				if ( control.IsPendingCreation( ) )
+				{
+					_control_block_pool.Destroy( control_block );
+					_control_block_pool.Deallocate( control_block, 1 );
+				}
+				else
+				{
+					control.ClearPendingChanges( );
+				}
+			}
+		}
+
+		// Dirty marks are not kept in the file, so every component found in it counts as changed (may throw)
+		ReserveDirty( num_chunks * CHUNK_SIZE );
+		SetDirty( 0, Count( ), true );
+
+		// The file fixes the capacity of the pool
+		const auto num_slots = num_chunks * CHUNK_SIZE;
+		_max_components = _max_components < num_slots ? _max_components : num_slots;
+
+		_mapped_header = header;
+		UpdateMappedHeader( );
+	}
+
+	/**
+	*	Writes the counts and the control block free list into the header of the mapped file, if the pool has one.
+	*/
+	inline void UpdateMappedHeader( )
+	{
+		if ( !_mapped_header )
+			return;
+
+		_mapped_header->_num_active_components = _num_active_components;
+		_mapped_header->_num_sleeping_components = _num_sleeping_components;
+		_mapped_header->_num_control_blocks = _control_block_pool.Size( );
+		_mapped_header->_free_list_head = _control_block_pool.GetFreeListHead( );
+	}
+
+#if COMPONENT_POOL_STATS
+
+	/**
+	*	Raises the component high water mark to the current number of components.
+	*/
+	inline void RecordHighWaterMarks( )
+	{
+		_stats._max_components = std::max( _stats._max_components, Count( ) );
+	}
+
+	/**
+	*	Raises the control block high water mark. Must be called with the deferred creates mutex held, or from a late update 
+	*	for concurrent control block pools.
+	*/
+	inline void RecordControlBlockHighWaterMark( )
+	{
+		_stats._max_control_blocks = std::max( _stats._max_control_blocks, _control_block_pool.Size( ) );
+	}
+
+#endif
+
+	/**
+	*	Adds the control block to the pending changes list. Thread safe.
+	*/
+	inline void PushPendingChanges( IndexType control_block )
+	{
+		auto &context = ControlBlock( control_block );
+
+		// Point the new head to the current head, retrying until nobody else changed the head under us
+		context._next = _pending_changes_head.load( );
+		while ( !_pending_changes_head.compare_exchange_weak( context._next, control_block ) ) { }
+	}
+
+	/**
+	*	Replaces the schedule of the component with a new one.
+	*
+	*	@param component the component to schedule
+	*	@param interval the number of frames between updates, zero to wake the component instead
+	*	@returns the ticket of the timer of the new schedule
+	*/
+	inline uint32_t StartTimer( const ComponentReference<ComponentType> &component, uint32_t interval )
+	{
+		// Check if the given reference is valid
+		if ( !component.IsValid( ) )
+			throw std::runtime_error( "Component reference was invalid." );
+
+		// Ensure control block actually belongs to this pool
+		if ( component._locator != &_locator )
+			throw std::runtime_error( "Tried to schedule component that did not belong to this component pool." );
+
+		// Schedules are kept by control block (may throw)
+		if ( component._context >= _schedules.size( ) )
+			_schedules.resize( component._context + 1 );
+
+		auto &schedule = _schedules [ component._context ];
+		schedule._tag = component._control_block_tag;
+		schedule._ticket++;
+		schedule._interval = interval;
+		schedule._last_update_time = _time;
+
+		return schedule._ticket;
+	}
+
+	/**
+	*	Makes any timer of the component stale and wakes the component.
+	*/
+	inline void WakeAndCancelTimer( const ComponentReference<ComponentType> &component )
+	{
+		// Wake the component, which also checks the reference
+		SetActive( component, true );
+
+		// SetActive leaves a sleep recorded earlier in the frame alone while the component is awake, a pending wake overrides it
+		auto &context = ControlBlock( component._context );
+		if ( context.IsPendingActiveStateChange( ) )
+			context.MarkActiveStateChange( true );
+
+		if ( component._context < _schedules.size( ) )
+			_schedules [ component._context ]._ticket++;
+	}
+
+	/**
+	*	Advances the pool time and the timing wheel, updating or waking the components whose timers are due.
+	*
+	*	@param dt the time since the last frame
+	*/
+	inline void UpdateTimers( const float dt )
+	{
+		_time += dt;
+
+		_timers.Advance( [ this ] ( IndexType control_block, uint32_t ticket )
+		{
+			// Drop timers of replaced, cancelled and deleted schedules
+			auto &schedule = _schedules [ control_block ];
+			auto &context = ControlBlock( control_block );
+			if ( schedule._ticket != ticket || schedule._tag != context.GetGarbageTag( ) )
+				return;
+
+			// The component was woken up early, which also ends the schedule
+			const auto sleeping = !context.IsComponentActive( );
+			const auto pending_sleep = context.IsPendingActiveStateChange( ) && !context.GetPendingActiveStateChange( );
+			if ( !sleeping && !pending_sleep )
+				return;
+
+			if ( schedule._interval == 0 )
+			{
+				// Wake the component, changes are applied by the late update
+				if ( context.MarkActiveStateChange( true ) )
+					PushPendingChanges( control_block );
+
+				return;
+			}
+
+			// Update the component where it lies in the sleeping block, unless it is not yet asleep or created
+			const auto index = context.GetComponentIndex( );
+			if ( sleeping && index != ComponentReferenceControlBlock::NULL_INDEX )
+			{
+				_components.Update( index, index + 1, static_cast< float >( _time - schedule._last_update_time ) );
+				schedule._last_update_time = _time;
+				COMPONENT_POOL_STAT( _stats._num_scheduled_updates++ );
+			}
+
+			_timers.Schedule( control_block, ticket, schedule._interval );
+		} );
+	}
+
+	/**
+	*	Adds a chain of control blocks linked through their next index to the pending changes list. Thread safe.
+	*
+	*	@param first the first control block of the chain
+	*	@param last the last control block of the chain
+	*/
+	inline void PushPendingChanges( IndexType first, IndexType last )
+	{
+		auto &context = ControlBlock( last );
+
+		// Point the end of the chain to the current head, retrying until nobody else changed the head under us
+		context._next = _pending_changes_head.load( );
+		while ( !_pending_changes_head.compare_exchange_weak( context._next, first ) ) { }
+	}
+
+	/**
+	*	Constructs the components recorded by CreateDeferred in the order they were recorded, up to the given budget.
+	*
+	*	@param budget the number of changes left to apply, reduced by the number of creates taken
+	*	@returns the first exception thrown while constructing the components
+	*/
+	inline std::exception_ptr ApplyDeferredCreates( size_t &budget )
+	{
+		// Take the oldest recorded creates the budget allows for, the rest wait for a later late update (may throw)
+		std::vector<DeferredCreate> creates;
+		{
+			std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+			const auto num_creates = std::min( budget, _deferred_creates.size( ) );
+			if ( _listener )
+				_events._created.reserve( _events._created.size( ) + num_creates );
+			if ( num_creates == _deferred_creates.size( ) )
+			{
+				creates.swap( _deferred_creates );
+			}
+			else
+			{
+				creates.reserve( num_creates );
+				std::move( _deferred_creates.begin( ), _deferred_creates.begin( ) + num_creates, std::back_inserter( creates ) );
+				_deferred_creates.erase( _deferred_creates.begin( ), _deferred_creates.begin( ) + num_creates );
+			}
+			budget -= num_creates;
+		}
+
+		// Keep the first failure so the remaining creates still get applied
+		std::exception_ptr exception;
+
+		for ( auto &create : creates )
+		{
+			const auto control_block = create._control_block;
+			const auto count = Count( );
+
+			try
+			{
+				// Can we create any more components 
+				if ( count == _max_components )
+					throw std::runtime_error( "Allocation limit reached for component store." );
+
+				// Make sure we have storage for the new component (may throw)
+				_components.Reserve( count + 1 );
+				_control_table.Reserve( count + 1 );
+				ReserveDirty( count + 1 );
+
+				// Construct the new component (may throw)
+				create._construct( _components, count );
+			}
+			catch ( ... )
+			{
+				if ( !exception )
+					exception = std::current_exception( );
+
+				// Invalidate any references to the component and reclaim the control block
+				_control_block_pool.Destroy( control_block );
+				_control_block_pool.Deallocate( control_block, 1 );
+				continue;
+			}
+
+			// Point the control block at the new component
+			auto &control = ControlBlock( control_block );
+			control._index = static_cast< IndexType >( count );
+			control.ClearPendingCreation( );
+
+			// Update id table to point to the new control block
+			_control_table [ count ] = control_block;
+			SetDirty( count, count + 1, true );
+
+			// We now have a valid component, update count
+			++_num_active_components;
+			COMPONENT_POOL_STAT( _stats._num_deferred_creates++ );
+			if ( _listener )
+				RecordEvent( _events._created, control_block );
+
+			// Queue any changes recorded while the component was waiting to be created
+			if ( control.IsPendingChanges( ) )
+				PushPendingChanges( control_block );
+		}
+
+		return exception;
+	}
+
+	/**
+	*	Sorts gathered changes into the order of their components.
+	*/
+	static inline void SortChanges( std::vector<ComponentReferenceControlBlock*> &changes )
+	{
+		std::sort( changes.begin( ), changes.end( ), [ ] ( const ComponentReferenceControlBlock *lhs, const ComponentReferenceControlBlock *rhs )
+		{
+			return lhs->_index < rhs->_index;
+		} );
+	}
+
+	/**
+	*	Gets the number of creates recorded by CreateDeferred that have not been applied yet.
+	*/
+	inline size_t NumDeferredCreates( ) const
+	{
+		std::lock_guard<std::mutex> lock( _deferred_creates_mutex );
+		return _deferred_creates.size( );
+	}
+
+	/**
+	*	Deletes all components gathered for deletion.
+	*
+	*	Components are destroyed in place and the holes they leave are filled by moving the last components of 
+	*	their block into them, so each surviving component moves at most once.
+	*/
+	inline void ApplyDeletes( )
+	{
+		// Is there anything to delete
+		if ( _pending_deletes.empty( ) )
+			return;
+
+		// Moving components invalidates any defragment pass underway
+		_sort_order.clear( );
+
+		// Hoist constants
+		const auto num_sleeping = _num_sleeping_components;
+		const auto count = Count( );
+
+		// Destroy the components, leaving holes in the control table
+		size_t num_deleted_sleeping = 0;
+		_deleted_indices.clear( );
+		for ( size_t i = 0; i < _pending_deletes.size( ); i++ )
+		{
+			PrefetchChange( _pending_deletes, i );
+
+			const auto index = _pending_deletes [ i ]->_index;
+			const auto control_block = _control_table [ index ];
+			if ( index < num_sleeping )
+				num_deleted_sleeping++;
+			_deleted_indices.push_back( index );
+
+			// Report the component while its handle still has the generation it was made with
+			if ( _listener )
+				RecordEvent( _events._deleted, control_block );
+
+			// Call destructor on the component, leaving the slot uninitialized for the next create
+			_components.Destroy( index );
+			_control_table [ index ] = ComponentReferenceControlBlock::NULL_INDEX;
+
+			// Clean up the control block now that the component has been removed
+			_control_block_pool.Destroy( control_block );
+
+			// Reclaim the control block
+			_control_block_pool.Deallocate( control_block, 1 );
+		}
+
+		// Get the new block boundaries
+		const auto new_num_sleeping = num_sleeping - num_deleted_sleeping;
+		const auto new_count = count - _pending_deletes.size( );
+
+		// Fill the holes left in the sleeping block with components from the end of the sleeping block (deletes are sorted by index)
+		auto source = num_sleeping;
+		for ( size_t i = 0; i < num_deleted_sleeping; i++ )
+		{
+			const auto hole = _deleted_indices [ i ];
+			if ( hole >= new_num_sleeping )
+				break;
+
+			// Find the last live sleeping component
+			do { --source; } while ( _control_table [ source ] == ComponentReferenceControlBlock::NULL_INDEX );
+			RelocateComponent( source, hole );
+		}
+
+		// The sleeping block shrinking leaves a gap at the start of the active block, fill it and the active holes from the end of the active block
+		source = count;
+		const auto gap_end = std::min( num_sleeping, new_count );
+		auto fill = [ this, &source ] ( size_t hole )
+		{
+			// Find the last live active component
+			do { --source; } while ( _control_table [ source ] == ComponentReferenceControlBlock::NULL_INDEX );
+			RelocateComponent( source, hole );
+		};
+		for ( auto hole = new_num_sleeping; hole < gap_end; hole++ )
+			fill( hole );
+		for ( auto i = num_deleted_sleeping; i < _pending_deletes.size( ); i++ )
+		{
+			const auto hole = _deleted_indices [ i ];
+			if ( hole >= new_count )
+				break;
+
+			fill( hole );
+		}
+
+		// Update the counters
+		_num_sleeping_components = new_num_sleeping;
+		_num_active_components = new_count - new_num_sleeping;
+		COMPONENT_POOL_STAT( _stats._num_deletes += _pending_deletes.size( ) );
+	}
+
+	/**
+	*	Wakes up all components gathered for waking.
+	*
+	*	Woken components are gathered at the end of the sleeping block, which then becomes the start of the active block.
+	*/
+	inline void ApplyWakes( )
+	{
+		// Is there anything to wake
+		if ( _pending_wakes.empty( ) )
+			return;
+
+		// Moving components invalidates any defragment pass underway
+		_sort_order.clear( );
+
+		// Deletes may have moved the woken components
+		SortChanges( _pending_wakes );
+
+		// Get the region at the end of the sleeping block the woken components need to end up in
+		const auto wake_begin = _num_sleeping_components - _pending_wakes.size( );
+
+		// Woken components already inside the region sort last and stay where they are
+		const auto num_outside = static_cast< size_t >( std::lower_bound( _pending_wakes.begin( ), _pending_wakes.end( ), wake_begin, [ ] ( const ComponentReferenceControlBlock *control, size_t index )
+		{
+			return control->_index < index;
+		} ) - _pending_wakes.begin( ) );
+
+		// Swap woken components outside the region with components inside the region that stay asleep
+		auto in_place = num_outside;
+		auto target = wake_begin;
+		for ( size_t i = 0; i < num_outside; i++ )
+		{
+			PrefetchChange( _pending_wakes, i );
+
+			// Step over the slots of woken components already in place
+			while ( in_place < _pending_wakes.size( ) && _pending_wakes [ in_place ]->_index == target )
+			{
+				in_place++;
+				target++;
+			}
+
+			SwapComponents( _pending_wakes [ i ]->_index, target++ );
+		}
+
+		// Move the block boundary and set the new active state
+		for ( auto *const control : _pending_wakes )
+		{
+			control->SetComponentActive( true );
+			control->ClearPendingChanges( );
+			if ( _listener )
+				RecordEvent( _events._woken, _control_table [ control->_index ] );
+		}
+
+		// Update the counters
+		_num_sleeping_components -= _pending_wakes.size( );
+		_num_active_components += _pending_wakes.size( );
+		COMPONENT_POOL_STAT( _stats._num_wakes += _pending_wakes.size( ) );
+	}
+
+	/**
+	*	Puts all components gathered for sleeping to sleep.
+	*
+	*	Slept components are gathered at the start of the active block, which then becomes the end of the sleeping block.
+	*/
+	inline void ApplySleeps( )
+	{
+		// Is there anything to put to sleep
+		if ( _pending_sleeps.empty( ) )
+			return;
+
+		// Moving components invalidates any defragment pass underway
+		_sort_order.clear( );
+
+		// Deletes and wakes may have moved the slept components
+		SortChanges( _pending_sleeps );
+
+		// Get the region at the start of the active block the slept components need to end up in
+		const auto sleep_end = _num_sleeping_components + _pending_sleeps.size( );
+
+		// Slept components already inside the region sort first and stay where they are
+		const auto num_in_place = static_cast< size_t >( std::lower_bound( _pending_sleeps.begin( ), _pending_sleeps.end( ), sleep_end, [ ] ( const ComponentReferenceControlBlock *control, size_t index )
+		{
+			return control->_index < index;
+		} ) - _pending_sleeps.begin( ) );
+
+		// Swap slept components outside the region with components inside the region that stay awake
+		size_t in_place = 0;
+		auto target = _num_sleeping_components;
+		for ( auto i = num_in_place; i < _pending_sleeps.size( ); i++ )
+		{
+			PrefetchChange( _pending_sleeps, i );
+
+			// Step over the slots of slept components already in place
+			while ( in_place < num_in_place && _pending_sleeps [ in_place ]->_index == target )
+			{
+				in_place++;
+				target++;
+			}
+
+			SwapComponents( _pending_sleeps [ i ]->_index, target++ );
+		}
+
+		// Move the block boundary and set the new active state
+		for ( auto *const control : _pending_sleeps )
+		{
+			control->SetComponentActive( false );
+			control->ClearPendingChanges( );
+			if ( _listener )
+				RecordEvent( _events._slept, _control_table [ control->_index ] );
+		}
+
+		// Update the counters
+		_num_sleeping_components += _pending_sleeps.size( );
+		_num_active_components -= _pending_sleeps.size( );
+		COMPONENT_POOL_STAT( _stats._num_sleeps += _pending_sleeps.size( ) );
+	}
+
+	/**
+	*	Gathers the control blocks of the active block in the order the key function sorts their components into.
+	*/
+	template <typename KeyFunction>
+	inline void PlanSortOrder( KeyFunction &key )
+	{
+		typedef typename std::decay<decltype( key( std::declval<const ComponentType&>( ) ) )>::type KeyType;
+		typedef std::pair<KeyType, IndexType> SortEntry;
+
+		// Drop any pass underway, so a throwing key function leaves no half gathered order behind
+		_sort_order.clear( );
+
+		// Hoist constants
+		const auto begin = _num_sleeping_components;
+		const auto end = Count( );
+
+		// Take every key up front so sorting never has to go back to the components
+		std::vector<SortEntry> entries;
+		entries.reserve( end - begin );
+		for ( auto i = begin; i < end; i++ )
+			entries.push_back( SortEntry( key( static_cast< const ComponentType& >( _components [ i ] ) ), _control_table [ i ] ) );
+
+		std::stable_sort( entries.begin( ), entries.end( ), [ ] ( const SortEntry &lhs, const SortEntry &rhs )
+		{
+			return lhs.first < rhs.first;
+		} );
+
+		// Control blocks follow their components as they swap, so they name each component wherever it currently is
+		_sort_order.reserve( entries.size( ) );
+		for ( const auto &entry : entries )
+			_sort_order.push_back( entry.second );
+
+		_sort_begin = begin;
+		_sort_cursor = 0;
+	}
+
+	/**
+	*	Swaps components into the gathered sort order.
+	*
+	*	@param budget the maximum number of components to swap
+	*	@returns true once every component is in place
+	*/
+	inline bool ApplySortOrder( size_t budget )
+	{
+		for ( ; _sort_cursor < _sort_order.size( ); _sort_cursor++ )
+		{
+			const auto target = _sort_begin + _sort_cursor;
+			const auto source = ControlBlock( _sort_order [ _sort_cursor ] )._index;
+
+			// Is the component already in place
+			if ( source == target )
+				continue;
+
+			if ( budget == 0 )
+				return false;
+
+			// Everything before the cursor is in place, so the component is always found after it
+			SwapComponents( source, target );
+			budget--;
+		}
+
+		// The pass is complete
+		_sort_order.clear( );
+		return true;
+	}
+
+	/**
+	*	Ensures there is a dirty mark for at least the given amount of components, if the pool tracks changes.
+	*/
+	inline void ReserveDirty( size_t capacity )
+	{
+		if ( TRACK_CHANGES )
+			_dirty.Reserve( capacity );
+	}
+
+	/**
+	*	Sets the dirty marks of the components in the given slot range, if the pool tracks changes.
+	*/
+	inline void SetDirty( size_t begin, size_t end, bool dirty )
+	{
+		if ( !TRACK_CHANGES )
+			return;
+
+		_dirty.ForEachSpan( begin, end, [ dirty ] ( uint8_t *marks, size_t count )
+		{
+			std::memset( marks, dirty ? 1 : 0, count );
+		} );
+	}
+
+	/**
+	*	Moves a component into an uninitialized slot and updates the control table.
+	*/
+	inline void RelocateComponent( size_t loc_index, size_t target_index )
+	{
+		// Move the component and its dirty mark
+		_components.Relocate( loc_index, target_index );
+		if ( TRACK_CHANGES )
+			_dirty [ target_index ] = _dirty [ loc_index ];
+
+		// Move the control table entry
+		const auto control = _control_table [ loc_index ];
+		_control_table [ loc_index ] = ComponentReferenceControlBlock::NULL_INDEX;
+		_control_table [ target_index ] = control;
+		ControlBlock( control )._index = static_cast< IndexType >( target_index );
+		COMPONENT_POOL_STAT( _stats._num_relocations++ );
+	}
+
+	/**
+	*	Swaps two components in memory and updates the control table.
+	*/
+	inline void SwapComponents( size_t loc_index, size_t target_index )
+	{
+		// Ensure we are actually moving the component
+		if ( loc_index != target_index )
+		{
+			// Swap components, dirty marks and control table entries
+			_components.Swap( loc_index, target_index );
+			if ( TRACK_CHANGES )
+				std::swap( _dirty [ loc_index ], _dirty [ target_index ] );
+			std::swap( ControlBlock( _control_table [ loc_index ] )._index, ControlBlock( _control_table [ target_index ] )._index );
+			std::swap( _control_table [ loc_index ], _control_table [ target_index ] );
+			COMPONENT_POOL_STAT( _stats._num_swaps++ );
+		}
+	}
+
+	/**
+	*	Records a lifecycle event for the component of the control block. Storage for the event must have been reserved.
+	*/
+	inline void RecordEvent( std::vector<ComponentHandle<ComponentType>> &events, IndexType control_block )
+	{
+		events.push_back( ComponentHandle<ComponentType>( control_block, ControlBlock( control_block ).GetGarbageTag( ) ) );
+	}
+
+	/**
+	*	Delivers the events gathered this frame to the listener.
+	*
+	*	Events are taken out of the pool first, so the listener may create, delete and change components as the 
+	*	events are delivered. Those changes are reported after the next late update.
+	*/
+	inline void NotifyListener( )
+	{
+		COMPONENT_POOL_PROFILE_SCOPE( "ComponentPool::NotifyListener" );
+
+		// Take the events, keeping the storage of the lists delivered last frame
+		_delivered_events.Clear( );
+		_delivered_events.Swap( _events );
+
+		// One call for each kind of event that happened
+		const auto &events = _delivered_events;
+		if ( !events._created.empty( ) )
+			_listener->OnCreate( events._created.data( ), events._created.size( ) );
+		if ( !events._deleted.empty( ) )
+			_listener->OnDelete( events._deleted.data( ), events._deleted.size( ) );
+		if ( !events._woken.empty( ) )
+			_listener->OnWake( events._woken.data( ), events._woken.size( ) );
+		if ( !events._slept.empty( ) )
+			_listener->OnSleep( events._slept.data( ), events._slept.size( ) );
+	}
+
+	/**
+	*	Publishes a copy of the active block and the handles of its components to the publisher.
+	*/
+	inline void Publish( std::true_type )
+	{
+		COMPONENT_POOL_PROFILE_SCOPE( "ComponentPool::Publish" );
+
+		// Hoist constants
+		const auto begin = _num_sleeping_components;
+		const auto end = Count( );
+
+		const auto published = _publisher->Publish( [ this, begin, end ] ( std::vector<ComponentType> &components, std::vector<ComponentHandle<ComponentType>> &handles )
+		{
+			// Make room for the whole active block up front (may throw)
+			components.reserve( end - begin );
+			handles.reserve( end - begin );
+
+			_components.ForEachSpan( begin, end, [ &components ] ( const ComponentType *span, size_t count )
+			{
+				components.insert( components.end( ), span, span + count );
+			} );
+
+			for ( auto i = begin; i < end; i++ )
+			{
+				const auto control_block = _control_table [ i ];
+				handles.push_back( ComponentHandle<ComponentType>( control_block, ControlBlock( control_block ).GetGarbageTag( ) ) );
+			}
+		} );
+
+		COMPONENT_POOL_STAT( _stats._num_publishes += published ? 1 : 0 );
+		COMPONENT_POOL_STAT( _stats._num_skipped_publishes += published ? 0 : 1 );
+		( void ) published;
+	}
+
+	/**
+	*	Components that cannot be published never have a publisher.
+	*/
+	inline void Publish( std::false_type ) { }
+
+	/**
+	*	Gets the number of components updated by each job of a parallel update.
+	*/
+	static inline size_t UpdateBatchSize( )
+	{
+		return StorageType::AlignBatchSize( Traits::UPDATE_BATCH_SIZE );
+	}
+
+	/**
+	*	Gets the number of components in the component pool.
+	*/
+	inline size_t Count( ) const
+	{
+		return _num_active_components + _num_sleeping_components;
+	}
+
+	/**< The control block object pool. */
+	ControlBlockPoolType _control_block_pool;
+
+	/**< The component object pool. */
+	StorageType _components;
+
+	/**< The dirty mark of every component slot, one byte each so components can be marked concurrently. Empty unless the pool tracks changes. */
+	ChunkedArray<uint8_t, CHUNK_SIZE> _dirty;
+
+	/**< The locator handed to component references. */
+	ComponentLocator<ComponentType> _locator;
+
+	/**< The control block table that maps component locations to reference control block indices. */
+	ChunkedArray<IndexType, CHUNK_SIZE> _control_table;
+
+	/**< The head of the pending changes list. */
+	std::atomic<IndexType> _pending_changes_head;
+
+	/**< The pending changes gathered by the current late update, kept to reuse its storage. */
+	std::vector<ComponentReferenceControlBlock*> _pending_changes;
+
+	/**< The pending deletes of the current late update. */
+	std::vector<ComponentReferenceControlBlock*> _pending_deletes;
+
+	/**< The pending wakes of the current late update. */
+	std::vector<ComponentReferenceControlBlock*> _pending_wakes;
+
+	/**< The pending sleeps of the current late update. */
+	std::vector<ComponentReferenceControlBlock*> _pending_sleeps;
+
+	/**< The changes late updates left for later because their budget ran out, oldest first. */
+	std::vector<ComponentReferenceControlBlock*> _carried_changes;
+
+	/**< The indices of the components deleted by the current late update. */
+	std::vector<size_t> _deleted_indices;
+
+	/**< The control blocks of the active block in sorted order for the defragment pass underway, empty if there is none. */
+	std::vector<IndexType> _sort_order;
+
+	/**< The start of the active block when the defragment pass was gathered. */
+	size_t _sort_begin;
+
+	/**< The position in the sort order the defragment pass has reached. */
+	size_t _sort_cursor;
+
+	/**< The control blocks allocated by the current CreateMany, kept to reuse its storage. */
+	std::vector<IndexType> _batch_control_blocks;
+
+	/**< The timers of scheduled components, keyed by control block. */
+	ComponentTimingWheel<Traits::TIMING_WHEEL_SIZE> _timers;
+
+	/**< The schedules of components, indexed by control block. */
+	std::vector<Schedule> _schedules;
+
+	/**< The sum of the time steps given to updates. */
+	double _time;
+
+	/**< The publisher late updates publish the active block to, null if the pool does not publish. */
+	ComponentPublisher<ComponentType> *_publisher;
+
+	/**< The listener late updates deliver lifecycle events to, null if events are not gathered. */
+	ComponentPoolListener<ComponentType> *_listener;
+
+	/**< The lifecycle events gathered since the last late update. */
+	LifecycleEvents _events;
+
+	/**< The lifecycle events being delivered to the listener, kept to reuse their storage. */
+	LifecycleEvents _delivered_events;
+
+	/**< The creates recorded by CreateDeferred. */
+	std::vector<DeferredCreate> _deferred_creates;
+
+	/**< Guards the recorded creates and control block allocation outside of late updates. */
+	mutable std::mutex _deferred_creates_mutex;
+
+	/**< The number of active components in the component pool. */
+	size_t _num_active_components;
+
+	/**< The number of sleeping components in the component pool. */
+	size_t _num_sleeping_components;
+
+	/**< The maximum amount of components the pool allows for. */
+	size_t _max_components;
+
+	/**< The header of the mapped file the pool is kept in, null if the pool is kept in memory. */
+	MappedHeader *_mapped_header;
+
+#if COMPONENT_POOL_STATS
+	/**< The counters of the pool. */
+	ComponentPoolStats _stats;
+#endif
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+
+#include "ComponentHandle.h"
+
+/**
+*	Receives the lifecycle events of the components of a component pool (see ComponentPool::SetListener).
+*
+*	Events are gathered over a frame and delivered at the end of each LateUpdate, once all pending changes have 
+*	been applied. Each kind of event is delivered in one call with the handles of every component it happened to, 
+*	and kinds with no events that frame are not called at all. Handles of created, woken and slept components 
+*	resolve through the pool, handles of deleted components no longer do but still identify what was removed.
+*
+*	A component that went through several changes in one frame is reported once for each. Listeners only need 
+*	to override the events they care about, and the handles are only valid for the duration of the call.
+*/
+template <typename ComponentType>
+class ComponentPoolListener
+{
+public:
+
+	/**
+	*	Destroys a listener.
+	*/
+	virtual ~ComponentPoolListener( ) { }
+
+	/**
+	*	Called with the components created since the last late update, including deferred creates.
+	*/
+	virtual void OnCreate( const ComponentHandle<ComponentType> *, size_t ) { }
+
+	/**
+	*	Called with the components deleted by the late update.
+	*/
+	virtual void OnDelete( const ComponentHandle<ComponentType> *, size_t ) { }
+
+	/**
+	*	Called with the components woken up by the late update.
+	*/
+	virtual void OnWake( const ComponentHandle<ComponentType> *, size_t ) { }
+
+	/**
+	*	Called with the components put to sleep by the late update.
+	*/
+	virtual void OnSleep( const ComponentHandle<ComponentType> *, size_t ) { }
+};
\ No newline at end of file
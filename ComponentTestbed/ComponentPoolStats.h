@@ -0,0 +1,153 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+
+/**
+*	Compile time switches for component pool instrumentation.
+*
+*	Define COMPONENT_POOL_STATS to 1 to have every component pool keep the counters below (see ComponentPool::GetStats).
+*	Stats are compiled out by default so shipping builds pay nothing for them.
+*
+*	Define COMPONENT_POOL_PROFILE_SCOPE( name ) before including the component pool to open a profiler zone for the rest of 
+*	the enclosing scope. It is placed at the top of Update, ParallelUpdate, LateUpdate, publishing and listener notification and given a string literal name.
+*	EG: #define COMPONENT_POOL_PROFILE_SCOPE( name ) ZoneScopedN( name )
+*/
+#ifndef COMPONENT_POOL_STATS
+#define COMPONENT_POOL_STATS 0
+#endif
+
+#if COMPONENT_POOL_STATS
+#define COMPONENT_POOL_STAT( statement ) statement
+#else
+#define COMPONENT_POOL_STAT( statement )
+#endif
+
+#ifndef COMPONENT_POOL_PROFILE_SCOPE
+#define COMPONENT_POOL_PROFILE_SCOPE( name )
+#endif
+
+/**
+*	Counters describing what a component pool has been doing.
+*
+*	Totals count since the pool was constructed or its stats were last reset. The current counts are taken when the stats are read.
+*/
+struct ComponentPoolStats
+{
+	inline ComponentPoolStats( )
+		: _num_updates( 0 )
+		, _num_late_updates( 0 )
+		, _num_creates( 0 )
+		, _num_deferred_creates( 0 )
+		, _num_deletes( 0 )
+		, _num_wakes( 0 )
+		, _num_sleeps( 0 )
+		, _num_swaps( 0 )
+		, _num_relocations( 0 )
+		, _num_scheduled_updates( 0 )
+		, _num_publishes( 0 )
+		, _num_skipped_publishes( 0 )
+		, _num_pending_changes( 0 )
+		, _num_carried_changes( 0 )
+		, _num_active_components( 0 )
+		, _num_sleeping_components( 0 )
+		, _num_control_blocks( 0 )
+		, _control_block_capacity( 0 )
+		, _num_timers( 0 )
+		, _max_components( 0 )
+		, _max_pending_changes( 0 )
+		, _max_control_blocks( 0 )
+	{
+
+	}
+
+	/**< The number of Update and ParallelUpdate calls. */
+	size_t _num_updates;
+
+	/**< The number of LateUpdate calls. */
+	size_t _num_late_updates;
+
+	/**< The number of components created straight away. */
+	size_t _num_creates;
+
+	/**< The number of components created by late updates for CreateDeferred. */
+	size_t _num_deferred_creates;
+
+	/**< The number of components deleted. */
+	size_t _num_deletes;
+
+	/**< The number of components woken up. */
+	size_t _num_wakes;
+
+	/**< The number of components put to sleep. */
+	size_t _num_sleeps;
+
+	/**< The number of component swaps done by late updates and sorting. */
+	size_t _num_swaps;
+
+	/**< The number of components moved into the holes left by deletes. */
+	size_t _num_relocations;
+
+	/**< The number of sleeping components updated by their timers. */
+	size_t _num_scheduled_updates;
+
+	/**< The number of copies of the active block published to readers. */
+	size_t _num_publishes;
+
+	/**< The number of publishes skipped because readers held every buffer that could be published into. */
+	size_t _num_skipped_publishes;
+
+	/**< The length of the pending changes list gathered by the last late update. */
+	size_t _num_pending_changes;
+
+	/**< The number of changes and deferred creates the last late update left for later because its budget ran out. */
+	size_t _num_carried_changes;
+
+	/**< The current number of active components. */
+	size_t _num_active_components;
+
+	/**< The current number of sleeping components. */
+	size_t _num_sleeping_components;
+
+	/**< The current number of control blocks handed out, including those of components waiting on a deferred create. */
+	size_t _num_control_blocks;
+
+	/**< The current number of control blocks the pool has storage for. */
+	size_t _control_block_capacity;
+
+	/**< The current number of component timers, including stale ones waiting to come due. */
+	size_t _num_timers;
+
+	/**< The most components the pool has held at once. */
+	size_t _max_components;
+
+	/**< The longest pending changes list gathered by a late update. */
+	size_t _max_pending_changes;
+
+	/**< The most control blocks handed out at once. */
+	size_t _max_control_blocks;
+};
\ No newline at end of file
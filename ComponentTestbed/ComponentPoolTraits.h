@@ -0,0 +1,110 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+
+#include "CRCBPool.h"
+#include "ComponentStorage.h"
+#include "ConcurrentCRCBPool.h"
+#include "SoAComponentStorage.h"
+
+/**
+*	The default compile time configuration for component pools.
+*/
+struct DefaultComponentPoolTraits
+{
+	/**< The number of components allocated at a time when a pool needs to grow. Must be a power of two. */
+	static const size_t CHUNK_SIZE = 256;
+
+	/**< Set to true if Update may be called on different components of this type from several threads at once. */
+	static const bool CONCURRENT_UPDATE = false;
+
+	/**< The minimum number of components updated by each job of a parallel update. Must be a power of two. */
+	static const size_t UPDATE_BATCH_SIZE = 64;
+
+	/**< The number of frame slots of the timing wheel that schedules components. Must be a power of two. */
+	static const size_t TIMING_WHEEL_SIZE = 256;
+
+	/**< How many entries ahead bulk lookups and late updates prefetch control blocks and components. */
+	static const size_t PREFETCH_DISTANCE = 8;
+
+	/**< Set to true to keep a dirty mark for every component, set by mutable access through its references (see ComponentPool::ForEachDirty). */
+	static const bool TRACK_CHANGES = false;
+
+	/**< The storage used for components. */
+	template <typename ComponentType, size_t CHUNK_SIZE>
+	using Storage = ComponentStorage<ComponentType, CHUNK_SIZE>;
+
+	/**< The pool component reference control blocks are allocated from. */
+	template <size_t CHUNK_SIZE>
+	using ControlBlockPool = CRCBPool<CHUNK_SIZE>;
+};
+
+/**
+*	The compile time configuration for component pools that store each component field in its own array.
+*
+*	See SoAComponentStorage for what component types need to provide.
+*/
+struct SoAComponentPoolTraits : DefaultComponentPoolTraits
+{
+	/**< The storage used for components. */
+	template <typename ComponentType, size_t CHUNK_SIZE>
+	using Storage = SoAComponentStorage<ComponentType, CHUNK_SIZE>;
+};
+
+/**
+*	The compile time configuration for component pools that many threads create components in through CreateDeferred.
+*
+*	Control blocks come from a lock free pool, so CreateDeferred only holds the pool lock to record the create.
+*/
+struct ConcurrentCreateComponentPoolTraits : DefaultComponentPoolTraits
+{
+	/**< The pool component reference control blocks are allocated from. */
+	template <size_t CHUNK_SIZE>
+	using ControlBlockPool = ConcurrentCRCBPool<CHUNK_SIZE>;
+};
+
+/**
+*	The compile time configuration for component pools that track which components changed, EG: for delta replication.
+*/
+struct ChangeTrackingComponentPoolTraits : DefaultComponentPoolTraits
+{
+	/**< Set to true to keep a dirty mark for every component, set by mutable access through its references (see ComponentPool::ForEachDirty). */
+	static const bool TRACK_CHANGES = true;
+};
+
+/**
+*	Compile time configuration for component pools.
+*
+*	Specialize this for a component type to tune how the pool of that type behaves. Specializations should 
+*	derive from DefaultComponentPoolTraits and only override the settings they need.
+*/
+template <typename ComponentType>
+struct ComponentPoolTraits : DefaultComponentPoolTraits
+{
+
+};
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+*	Software prefetch hints for component pools.
+*
+*	Component pools prefetch control blocks and components a few entries ahead wherever they follow indices rather
+*	than walk memory in order. EG: Resolving handles and references in bulk and applying pending changes.
+*
+*	Define COMPONENT_PREFETCH( address ) before including the component pool to replace the hint, or define it empty 
+*	to turn prefetching off. The hint must not fault on any address, as prefetches may run past what is later used.
+*/
+#ifndef COMPONENT_PREFETCH
+#if defined( _MSC_VER ) && ( defined( _M_IX86 ) || defined( _M_X64 ) )
+#include <xmmintrin.h>
+#define COMPONENT_PREFETCH( address ) _mm_prefetch( reinterpret_cast< const char* >( address ), _MM_HINT_T0 )
+#elif defined( __GNUC__ )
+#define COMPONENT_PREFETCH( address ) __builtin_prefetch( address )
+#else
+#define COMPONENT_PREFETCH( address )
+#endif
+#endif
\ No newline at end of file
@@ -0,0 +1,294 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "ComponentHandle.h"
+
+template <typename ComponentType>
+class ComponentPublisher;
+
+/**
+*	A reader's hold on a state published by a ComponentPublisher.
+*
+*	The published components and their handles stay untouched for as long as the view is held, however many frames
+*	the pool moves on in the meantime. Views are movable but not copyable, and must be released before their publisher 
+*	is destroyed.
+*/
+template <typename ComponentType>
+class ComponentPublishedView final
+{
+	/**< Allow publishers to hand out views. */
+	friend class ComponentPublisher<ComponentType>;
+
+public:
+
+	/**
+	*	Constructs an empty view.
+	*/
+	inline ComponentPublishedView( )
+		: _buffer( nullptr )
+	{
+
+	}
+
+	/**
+	*	Move constructor for views.
+	*/
+	inline ComponentPublishedView( ComponentPublishedView &&other )
+		: _buffer( other._buffer )
+	{
+		other._buffer = nullptr;
+	}
+
+	/**
+	*	Move assignment operator for views.
+	*/
+	inline ComponentPublishedView& operator=( ComponentPublishedView &&other )
+	{
+		if ( this != std::addressof( other ) )
+		{
+			Release( );
+			_buffer = other._buffer;
+			other._buffer = nullptr;
+		}
+
+		return *this;
+	}
+
+	/**
+	*	View copying is forbidden.
+	*/
+	ComponentPublishedView( ComponentPublishedView const& ) = delete;
+
+	/**
+	*	View copying is forbidden.
+	*/
+	ComponentPublishedView& operator=( ComponentPublishedView const& ) = delete;
+
+	/**
+	*	Releases the view.
+	*/
+	inline ~ComponentPublishedView( )
+	{
+		Release( );
+	}
+
+	/**
+	*	Lets the publisher reuse the published state. The view is empty afterwards.
+	*/
+	inline void Release( )
+	{
+		if ( _buffer )
+			_buffer->_num_readers--;
+
+		_buffer = nullptr;
+	}
+
+	/**
+	*	Checks if the view holds no published state, as nothing had been published when it was acquired.
+	*/
+	inline bool IsEmpty( ) const { return _buffer == nullptr; }
+
+	/**
+	*	Gets the generation of the published state, which counts up by one with every publish.
+	*/
+	inline uint64_t GetGeneration( ) const { return _buffer ? _buffer->_generation : 0; }
+
+	/**
+	*	Gets the number of published components.
+	*/
+	inline size_t Size( ) const { return _buffer ? _buffer->_components.size( ) : 0; }
+
+	/**
+	*	Gets the published components, densely packed in the order of the active block when they were published.
+	*/
+	inline const ComponentType* GetComponents( ) const { return _buffer ? _buffer->_components.data( ) : nullptr; }
+
+	/**
+	*	Gets the handle of each published component, which tells readers which component it was.
+	*/
+	inline const ComponentHandle<ComponentType>* GetHandles( ) const { return _buffer ? _buffer->_handles.data( ) : nullptr; }
+
+private:
+
+	/**
+	*	A published state of the components of a pool.
+	*/
+	struct Buffer
+	{
+		inline Buffer( )
+			: _generation( 0 )
+			, _num_readers( 0 )
+		{
+
+		}
+
+		/**< The published copies of the components. */
+		std::vector<ComponentType> _components;
+
+		/**< The handles of the published components. */
+		std::vector<ComponentHandle<ComponentType>> _handles;
+
+		/**< The generation of the published state. */
+		uint64_t _generation;
+
+		/**< The number of views holding the buffer. */
+		std::atomic<uint32_t> _num_readers;
+	};
+
+	/**
+	*	Constructs a view holding the given buffer, which has already counted the view as a reader.
+	*/
+	inline explicit ComponentPublishedView( Buffer *buffer )
+		: _buffer( buffer )
+	{
+
+	}
+
+	/**< The held buffer, null if the view is empty. */
+	Buffer *_buffer;
+};
+
+/**
+*	Publishes copies of the active block of a component pool to reader threads (see ComponentPool::SetPublisher).
+*
+*	Published states rotate through a chain of three buffers. The owning thread copies the components into a buffer no 
+*	reader holds and then makes it the latest, and readers acquire the latest buffer without taking any lock. This way a 
+*	reader may hold on to a state for as long as it likes while the pool keeps moving its components around. Should
+*	readers hold on to both buffers that are not the latest, publishing is skipped until one is released.
+*
+*	Acquire may be called from any thread. Everything else must only be called from the thread that owns the pool.
+*/
+template <typename ComponentType>
+class ComponentPublisher final
+{
+	/**< The published state buffers. */
+	typedef typename ComponentPublishedView<ComponentType>::Buffer Buffer;
+
+public:
+
+	/**< The number of buffers published states rotate through. */
+	static const size_t NUM_BUFFERS = 3;
+
+	/**
+	*	Constructs a publisher that has published nothing yet.
+	*/
+	inline ComponentPublisher( )
+		: _latest( nullptr )
+		, _generation( 0 )
+	{
+
+	}
+
+	/**
+	*	Publisher copying is forbidden.
+	*/
+	ComponentPublisher( ComponentPublisher const& ) = delete;
+
+	/**
+	*	Publisher copying is forbidden.
+	*/
+	ComponentPublisher& operator=( ComponentPublisher const& ) = delete;
+
+	/**
+	*	Acquires the latest published state. Thread safe.
+	*
+	*	@returns a view of the latest published state, empty if nothing has been published yet
+	*/
+	inline ComponentPublishedView<ComponentType> Acquire( ) const
+	{
+		for ( ;; )
+		{
+			auto *buffer = _latest.load( );
+			if ( !buffer )
+				return ComponentPublishedView<ComponentType>( );
+
+			// Count ourselves as a reader, then make sure the buffer was still the latest so the publisher cannot have picked it
+			buffer->_num_readers++;
+			if ( _latest.load( ) == buffer )
+				return ComponentPublishedView<ComponentType>( buffer );
+
+			buffer->_num_readers--;
+		}
+	}
+
+	/**
+	*	Publishes a new state into a buffer no reader holds.
+	*
+	*	@param fill the function called as fill( components, handles ) with the emptied vectors of the buffer to fill
+	*	@returns false if readers held every buffer that could be published into
+	*/
+	template <typename Function>
+	inline bool Publish( Function fill )
+	{
+		// Find a buffer that is neither the latest nor held by a reader, readers only ever take the latest
+		auto *const latest = _latest.load( );
+		Buffer *target = nullptr;
+		for ( auto &buffer : _buffers )
+		{
+			if ( &buffer != latest && buffer._num_readers.load( ) == 0 )
+			{
+				target = &buffer;
+				break;
+			}
+		}
+
+		if ( !target )
+			return false;
+
+		// Fill the buffer (may throw)
+		target->_components.clear( );
+		target->_handles.clear( );
+		fill( target->_components, target->_handles );
+		target->_generation = ++_generation;
+
+		// Hand the buffer over to readers
+		_latest.store( target );
+		return true;
+	}
+
+	/**
+	*	Gets the generation of the latest published state, zero if nothing has been published yet.
+	*/
+	inline uint64_t GetGeneration( ) const { return _generation; }
+
+private:
+
+	/**< The buffers published states rotate through. */
+	Buffer _buffers [ NUM_BUFFERS ];
+
+	/**< The latest published buffer, null if nothing has been published yet. */
+	std::atomic<Buffer*> _latest;
+
+	/**< The generation of the latest published state. */
+	uint64_t _generation;
+};
\ No newline at end of file
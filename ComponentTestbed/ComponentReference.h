@@ -26,16 +26,20 @@
 */
 
 class ComponentService;
+#include "ComponentLocator.h"
 #include "ComponentReferenceControlBlock.h"
+#include "ComponentValidation.h"
 
 /**
 *	Managed references for components.
+*
+*	References are the locator of the component pool plus the index of the control block in that pool. 
 */
 template <typename ComponentType>
 class ComponentReference final
 {
 	/**< Allow component pools to get at the component reference control block. */
-	template <typename T>
+	template <typename T, typename Traits>
 	friend class ComponentPool;
 
 public:
@@ -44,7 +48,8 @@ public:
 	*	Constructs a new component reference.
 	*/
 	inline ComponentReference( )
-		: _context( nullptr )
+		: _locator( nullptr )
+		, _context( ComponentReferenceControlBlock::NULL_INDEX )
 		, _control_block_tag( 0 )
 	{
 
@@ -53,11 +58,13 @@ public:
 	/**
 	*	Constructs a new component reference.
 	*
-	*	@param context the control block for this component
+	*	@param locator the locator of the component pool of this component
+	*	@param context the index of the control block for this component
 	*/
-	inline ComponentReference( ComponentReferenceControlBlock *context )
-		: _context( context )
-		, _control_block_tag( context->GetGarbageTag( ) ) // Copy the tag at the time of reference instantiation
+	inline ComponentReference( const ComponentLocator<ComponentType> *locator, ComponentReferenceControlBlock::IndexType context )
+		: _locator( locator )
+		, _context( context )
+		, _control_block_tag( locator->GetControlBlock( context ).GetGarbageTag( ) ) // Copy the tag at the time of reference instantiation
 	{ 
 
 	}
@@ -82,11 +89,13 @@ public:
 	*	@param other the reference to move
 	*/
 	inline ComponentReference( ComponentReference &&other )
-		: _context( other._context )
+		: _locator( other._locator )
+		, _context( other._context )
 		, _control_block_tag( other._control_block_tag )
 	{
 		// Clear other
-		other._context = nullptr;
+		other._locator = nullptr;
+		other._context = ComponentReferenceControlBlock::NULL_INDEX;
 		other._control_block_tag = 0;
 	}
 
@@ -109,7 +118,8 @@ public:
 			*this = other;
 
 			// Clear values from other
-			other._context = nullptr;
+			other._locator = nullptr;
+			other._context = ComponentReferenceControlBlock::NULL_INDEX;
 			other._control_block_tag = 0;
 		}
 
@@ -121,7 +131,8 @@ public:
 	*/
 	ComponentReference& operator=( std::nullptr_t )
 	{
-		_context = nullptr;
+		_locator = nullptr;
+		_context = ComponentReferenceControlBlock::NULL_INDEX;
 		_control_block_tag = 0;
 
 		return *this;
@@ -129,6 +140,8 @@ public:
 
 	/**
 	*	Gets a raw pointer to the managed component.
+	*
+	*	Marks the component as changed if its pool tracks changes (see ComponentPool::ForEachDirty).
 	*/
 	inline ComponentType* Get( )
 	{
@@ -137,7 +150,9 @@ public:
 			throw std::runtime_error( "Tried to dereference component but reference has been invalidated." );
 
 		// Return type discovered component pointer
-		return static_cast<ComponentType*>( _context->GetComponentPtr( ) );
+		const auto index = _locator->GetControlBlock( _context ).GetComponentIndex( );
+		_locator->MarkDirty( index );
+		return _locator->GetComponent( index );
 	}
 
 	/**
@@ -150,7 +165,35 @@ public:
 			throw std::runtime_error( "Tried to dereference component but reference has been invalidated." );
 
 		// Return type discovered component pointer
-		return const_cast< const ComponentType* >( static_cast< ComponentType* >( _context->GetComponentPtr( ) ) );
+		return const_cast< const ComponentType* >( _locator->GetComponent( _locator->GetControlBlock( _context ).GetComponentIndex( ) ) );
+	}
+
+	/**
+	*	Gets a raw pointer to the managed component without checking the reference first.
+	*
+	*	The reference must be valid. This is only checked when COMPONENT_POOL_VALIDATION is set, so hot paths that 
+	*	already know their references are valid can skip the check and the exception handling behind it. Marks the 
+	*	component as changed like Get.
+	*/
+	inline ComponentType* GetUnchecked( )
+	{
+		COMPONENT_POOL_ASSERT( IsValid( ), "Tried to dereference component but reference has been invalidated." );
+
+		const auto index = _locator->GetControlBlock( _context ).GetComponentIndex( );
+		_locator->MarkDirty( index );
+		return _locator->GetComponent( index );
+	}
+
+	/**
+	*	Gets a raw pointer to the managed component without checking the reference first.
+	*
+	*	The reference must be valid. This is only checked when COMPONENT_POOL_VALIDATION is set.
+	*/
+	inline const ComponentType* GetUnchecked( ) const
+	{
+		COMPONENT_POOL_ASSERT( IsValid( ), "Tried to dereference component but reference has been invalidated." );
+
+		return const_cast< const ComponentType* >( _locator->GetComponent( _locator->GetControlBlock( _context ).GetComponentIndex( ) ) );
 	}
 
 	/**
@@ -200,18 +243,43 @@ public:
 	*/
 	inline bool IsValid( ) const
 	{
-		// The reference is valid while we have a context pointer, 
+		// The reference is valid while we have a locator, 
 		// the cached tag and control block tag match
-		return _context && _control_block_tag == _context->GetGarbageTag( );
+		return _locator && _control_block_tag == _locator->GetControlBlock( _context ).GetGarbageTag( );
+	}
+
+	/**
+	*	Marks the component as changed if its pool tracks changes, for changes made without going through the reference.
+	*	Does nothing for components that have not been created yet.
+	*/
+	inline void MarkDirty( ) const
+	{
+		// Check that the reference is valid before looking up its component
+		if ( !IsValid( ) )
+			throw std::runtime_error( "Tried to mark component as changed but reference has been invalidated." );
+
+		_locator->MarkDirty( _locator->GetControlBlock( _context ).GetComponentIndex( ) );
+	}
+
+	/**
+	*	Gets if the component has been deleted and is waiting for a late update to remove it.
+	*	Such components stay valid until then, as late updates never carry deletes over.
+	*/
+	inline bool IsPendingDeletion( ) const
+	{
+		return IsValid( ) && _locator->GetControlBlock( _context ).IsPendingDeletion( );
 	}
 
 private:
 
-	/**< Component control block for this referece. */
-	ComponentReferenceControlBlock *_context;
+	/**< The locator of the component pool of this reference. */
+	const ComponentLocator<ComponentType> *_locator;
+
+	/**< Index of the component control block for this referece. */
+	ComponentReferenceControlBlock::IndexType _context;
 
 	/**< The control block tag at the time of being given a control block. */
-	size_t _control_block_tag;
+	uint32_t _control_block_tag;
 };
 
 namespace std
@@ -224,7 +292,7 @@ namespace std
 	{
 		size_t operator( )( const ComponentReference<ComponentType> &ref) const
 		{
-			return std::hash<ComponentType*>( ref.Get( ) );
+			return std::hash<const ComponentType*>( )( ref.Get( ) );
 		}
 	};
 
@@ -290,74 +358,78 @@ bool operator>=( const ComponentReference<T>& lhs, const ComponentReference<U>&
 	return lhs.Get( ) >= rhs.Get( );
 }
 
+/**
+*	Comparisons against nullptr only check the reference for validity so they never throw.
+*/
+
 template< class T >
-bool operator==( const ComponentReference<T>& lhs, std::nullptr_t rhs )
+bool operator==( const ComponentReference<T>& lhs, std::nullptr_t )
 {
-	return lhs.Get( ) == rhs;
+	return !lhs.IsValid( );
 }
 
 template< class T >
-bool operator==( std::nullptr_t lhs, const ComponentReference<T>& rhs )
+bool operator==( std::nullptr_t, const ComponentReference<T>& rhs )
 {
-	return lhs == rhs.Get( );
+	return !rhs.IsValid( );
 }
 
 template< class T >
-bool operator!=( const ComponentReference<T>& lhs, std::nullptr_t rhs )
+bool operator!=( const ComponentReference<T>& lhs, std::nullptr_t )
 {
-	return lhs.Get( ) == rhs;
+	return lhs.IsValid( );
 }
 
 template< class T >
-bool operator!=( std::nullptr_t lhs, const ComponentReference<T>& rhs )
+bool operator!=( std::nullptr_t, const ComponentReference<T>& rhs )
 {
-	return lhs != rhs.Get( );
+	return rhs.IsValid( );
 }
 
 template< class T >
-bool operator<( const ComponentReference<T>& lhs, std::nullptr_t rhs )
+bool operator<( const ComponentReference<T>&, std::nullptr_t )
 {
-	return lhs.Get( ) < rhs;
+	return false;
 }
 
 template< class T >
-bool operator<( std::nullptr_t lhs, const ComponentReference<T>& rhs )
+bool operator<( std::nullptr_t, const ComponentReference<T>& rhs )
 {
-	return lhs < rhs.Get( );
+	return rhs.IsValid( );
 }
 
 template< class T >
-bool operator<=( const ComponentReference<T>& lhs, std::nullptr_t rhs )
+bool operator<=( const ComponentReference<T>& lhs, std::nullptr_t )
 {
-	return lhs.Get( ) <= rhs;
+	return !lhs.IsValid( );
 }
 
 template< class T >
-bool operator<=( std::nullptr_t lhs, const ComponentReference<T>& rhs )
+bool operator<=( std::nullptr_t, const ComponentReference<T>& )
 {
-	return lhs <= rhs.Get( );
+	return true;
 }
 
 template< class T >
-bool operator>( const ComponentReference<T>& lhs, std::nullptr_t rhs )
+bool operator>( const ComponentReference<T>& lhs, std::nullptr_t )
 {
-	return lhs.Get( ) > rhs
+	return lhs.IsValid( );
 }
 
 template< class T >
-bool operator>( std::nullptr_t lhs, const ComponentReference<T>& rhs )
+bool operator>( std::nullptr_t, const ComponentReference<T>& )
 {
-	return lhs > rhs.Get( );
+	return false;
 }
 
 template< class T >
-bool operator>=( const ComponentReference<T>& lhs, std::nullptr_t rhs )
+bool operator>=( const ComponentReference<T>&, std::nullptr_t )
 {
-	return lhs.Get( ) >= rhs;
+	return true;
 }
 
 template< class T >
-bool operator>=( std::nullptr_t lhs, const ComponentReference<T>& rhs )
+bool operator>=( std::nullptr_t, const ComponentReference<T>& rhs )
 {
-	return lhs >= rhs.Get( );
+	return !rhs.IsValid( );
 }
\ No newline at end of file
@@ -30,96 +30,117 @@
 #include <utility>
 
 ComponentReferenceControlBlock::ComponentReferenceControlBlock( )
-	: _next( nullptr )
-	, _component( nullptr )
-	, _tag( 0 )
-	, _flags( 0 )
-	
+	: _next( NULL_INDEX )
+	, _index( NULL_INDEX )
+	, _state( 0 )
 {
 
 }
 
-ComponentReferenceControlBlock::~ComponentReferenceControlBlock( )
+void ComponentReferenceControlBlock::Release( ) _NOEXCEPT
 {
 	// Clear component state
-	_component = nullptr;
-	_flags = 0;
-	_next = nullptr;
+	_index = NULL_INDEX;
+	_next = NULL_INDEX;
 
-	// Increment garbage detection tag
-	_tag++;
+	// Clear the flags and increment garbage detection tag
+	_state = ( _state.load( ) & ~FLAG_MASK ) + TAG_ONE;
 }
 
-ComponentReferenceControlBlock::ComponentReferenceControlBlock( void* component )
-	: _next( nullptr )
-	, _component( component )
-	, _flags( IS_ACTIVE )
-	
-	/* Garbage detection tag is only changed on initial contruction and any future destructions. */
+void ComponentReferenceControlBlock::Initialize( IndexType index ) _NOEXCEPT
 {
-
+	/* Garbage detection tag is only changed on initial contruction and any future releases. */
+	_next = NULL_INDEX;
+	_index = index;
+	_state = ( _state.load( ) & ~FLAG_MASK ) | IS_ACTIVE;
 }
 
 bool ComponentReferenceControlBlock::IsComponentActive() const
 {
-	return _flags & IS_ACTIVE;
+	return ( _state & IS_ACTIVE ) != 0;
 }
 
 void ComponentReferenceControlBlock::SetComponentActive(const bool new_active)
 {
-	// Get the new bit value
-	FlagType f = new_active ? IS_ACTIVE : 0;
-
-	// Clear and set the new bit value
-	_flags &= ~IS_ACTIVE;
-	_flags |= f;
+	// Set or clear the bit
+	if ( new_active )
+		_state |= IS_ACTIVE;
+	else
+		_state &= ~static_cast< StateType >( IS_ACTIVE );
 }
 
-void ComponentReferenceControlBlock::MarkActiveStateChange(const bool new_active)
+bool ComponentReferenceControlBlock::MarkActiveStateChange(const bool new_active)
 {
 	// Get the new bit value
 	FlagType f = new_active ? PENDING_ACTIVE : PENDING_SLEEP;
 
 	// Set the pending flag
-	_flags |= f;
+	return !( _state.fetch_or( f ) & PENDING_MASK );
 }
 
 bool ComponentReferenceControlBlock::IsPendingChanges() const
 {
-	return (_flags & PENDING_ACTIVE) || (_flags & PENDING_SLEEP) || (_flags & PENDING_DELETE);
+	return ( _state & PENDING_MASK ) != 0;
 }
 
 bool ComponentReferenceControlBlock::IsPendingActiveStateChange() const
 {
-	return (_flags & PENDING_ACTIVE) || (_flags & PENDING_SLEEP);
+	return ( _state & ( PENDING_ACTIVE | PENDING_SLEEP ) ) != 0;
 }
  
 bool ComponentReferenceControlBlock::GetPendingActiveStateChange() const
 {
-	return _flags & PENDING_ACTIVE;
+	return ( _state & PENDING_ACTIVE ) != 0;
 }
 
 void ComponentReferenceControlBlock::ClearPendingChanges()
 {
-	_flags &= ~(PENDING_ACTIVE | PENDING_SLEEP | PENDING_DELETE);
+	_state &= ~static_cast< StateType >( PENDING_ACTIVE | PENDING_SLEEP | PENDING_DELETE );
 }
 
-void ComponentReferenceControlBlock::MarkForDeletion( )
+bool ComponentReferenceControlBlock::MarkForDeletion( )
 {
-	_flags |= PENDING_DELETE;
+	return !( _state.fetch_or( PENDING_DELETE ) & PENDING_MASK );
 }
 
 bool ComponentReferenceControlBlock::IsPendingDeletion( ) const
 {
-	return _flags & PENDING_DELETE;
+	return ( _state & PENDING_DELETE ) != 0;
+}
+
+void ComponentReferenceControlBlock::MarkPendingCreation( )
+{
+	_state |= PENDING_CREATE;
+}
+
+bool ComponentReferenceControlBlock::IsPendingCreation( ) const
+{
+	return ( _state & PENDING_CREATE ) != 0;
+}
+
+void ComponentReferenceControlBlock::ClearPendingCreation( )
+{
+	_state &= ~static_cast< StateType >( PENDING_CREATE );
+}
+
+uint32_t ComponentReferenceControlBlock::GetGarbageTag( ) const
+{
+	return static_cast< uint32_t >( _state >> TAG_SHIFT );
+}
+
+uint64_t ComponentReferenceControlBlock::GetFullGarbageTag( ) const
+{
+	return _state >> TAG_SHIFT;
 }
 
-size_t ComponentReferenceControlBlock::GetGarbageTag( ) const
+void ComponentReferenceControlBlock::Restore( uint64_t tag, IndexType index, bool active ) _NOEXCEPT
 {
-	return _tag;
+	_next = NULL_INDEX;
+	_index = index;
+	_state = ( static_cast< StateType >( tag ) << TAG_SHIFT ) | ( active ? static_cast< StateType >( IS_ACTIVE ) : 0 );
 }
 
-void* ComponentReferenceControlBlock::GetComponentPtr( ) const
+ComponentReferenceControlBlock::IndexType ComponentReferenceControlBlock::GetComponentIndex( ) const
 {
-	return _component;
+	return _index;
 }
\ No newline at end of file
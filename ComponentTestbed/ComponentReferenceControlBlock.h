@@ -25,41 +25,56 @@
 * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <atomic>
 #include <cstdint>
 #include <type_traits>
 
 /**
 *	The control block for component references.
+*
+*	Control blocks are packed into 16 bytes so four share a cache line. They live in a CRCBPool and are named by their
+*	index into it, and they locate their component by its index in the component pool rather than by address.
+*
+*	Pending change flags may be marked from several threads at once. All other state is only changed by the owning component pool.
 */
 class ComponentReferenceControlBlock final
 {
-	/**< Allow component pools to get to the next pointer and component pointer. */
-	template <typename T>
+	/**< Allow component pools to get to the next index and component index. */
+	template <typename T, typename Traits>
 	friend class ComponentPool;
 
-	/**< Allow the CRCBPools to get at the next pointer. */
-	template <size_t MAX_SIZE>
+	/**< Allow the CRCBPools to get at the next index. */
+	template <size_t CHUNK_SIZE>
 	friend class CRCBPool;
 
 public:
+
+	/**< The type of control block and component indices. */
+	typedef uint32_t IndexType;
+
+	/**< The index that names no control block or component. */
+	static const IndexType NULL_INDEX = UINT32_MAX;
+
 	/**
 	*	Creates a component reference control block and sets its initial global state.
 	*/
 	ComponentReferenceControlBlock( );
 
 	/**
-	*	Initializes the control block.
+	*	Initializes the control block for a new component.
+	*
+	*	Control blocks are reset in place rather than reconstructed so the garbage tag survives reuse.
 	*
-	*	@param component the pointer ot the component
+	*	@param index the index of the component in its component pool, NULL_INDEX if it has not been created yet
 	*/
-	ComponentReferenceControlBlock( void * component ) _NOEXCEPT;
+	void Initialize( IndexType index ) _NOEXCEPT;
 
 	/**
-	*	Cleans up a component reference control block.
+	*	Cleans up a component reference control block once its component is gone.
 	*
 	*	Garbage tag is incremented.
 	*/
-	~ComponentReferenceControlBlock( ) _NOEXCEPT;
+	void Release( ) _NOEXCEPT;
 
 	/**
 	*	Signals the control block that the component we manage has been deleted.
@@ -81,11 +96,12 @@ public:
 	void SetComponentActive(const bool new_active);
 
 	/**
-	*	Marks the component to have its active state changed at the end of the update tick. 
+	*	Marks the component to have its active state changed at the end of the update tick. Thread safe.
 	*
 	*	@param new_active the new desired active state.
+	*	@returns true if the component had no pending changes before this call.
 	*/
-	void MarkActiveStateChange(const bool new_active);
+	bool MarkActiveStateChange(const bool new_active);
 
 	/**
 	*	Gets if the component has any pending changes. 
@@ -107,9 +123,11 @@ public:
 	void ClearPendingChanges();
 
 	/**
-	*	Marks the component to be deleted.
+	*	Marks the component to be deleted. Thread safe.
+	*
+	*	@returns true if the component had no pending changes before this call.
 	*/
-	void MarkForDeletion( );
+	bool MarkForDeletion( );
 
 	/**
 	*	Gets if the component has been marked for deletion.
@@ -123,40 +141,86 @@ public:
 	*/
 	bool GetPendingActiveStateChange() const;
 
+	/**
+	*	Marks the component as not yet constructed. The component will be created at the end of the update tick.
+	*/
+	void MarkPendingCreation( );
+
+	/**
+	*	Gets if the component is waiting to be constructed.
+	*/
+	bool IsPendingCreation( ) const;
+
+	/**
+	*	Clears the pending creation flag once the component has been constructed.
+	*/
+	void ClearPendingCreation( );
+
 	/**
 	*	Gets the current garbage tag of the control block.
 	*
+	*	References and handles only keep the low 32 bits of the tag, which is what this returns.
+	*
 	*	@returns the current garbage tag
 	*/
-	size_t GetGarbageTag( ) const;
+	uint32_t GetGarbageTag( ) const;
+
+	/**
+	*	Gets the whole garbage tag of the control block, for snapshots of the pool.
+	*
+	*	@returns the current garbage tag with all of its bits
+	*/
+	uint64_t GetFullGarbageTag( ) const;
+
+	/**
+	*	Overwrites the control block state when restoring a snapshot of the pool. Any pending changes are dropped.
+	*
+	*	@param tag the whole garbage tag to restore
+	*	@param index the index of the component in its component pool, NULL_INDEX if the control block is free
+	*	@param active the active state of the component
+	*/
+	void Restore( uint64_t tag, IndexType index, bool active ) _NOEXCEPT;
 
 	/**
-	*	Gets the current component pointer that the control block manages.
+	*	Gets the index of the component in its component pool.
 	*
-	*	@returns the current cached component pointer
+	*	@returns the current cached component index, NULL_INDEX if the component does not exist (yet)
 	*/
-	void* GetComponentPtr( ) const;
+	IndexType GetComponentIndex( ) const;
 
 private:
 
-	/**< The next component control block in the pending changes list or control block free list. */
-	ComponentReferenceControlBlock *_next;
+	/**< The next control block in the pending changes list or the control block free list. A control block is never on both. */
+	IndexType _next;
+
+	/**< The index of the component in its component pool. */
+	IndexType _index;
 
-	/**< The component. */
-	void *_component;
+	/**< The control block state. Shares one word between the tag and the flags. */
+	typedef uint64_t StateType;
+	std::atomic<StateType> _state;
 
-	/**< Control block tag. Gets incremented each time the component we point to is deleted. NOTE THIS STATE IS PERSISTENT ACROSS REUSES TO DETECT GARBAGE. */
-	size_t _tag;
+	/**< The state bits below the tag, which hold the flags. */
+	static const StateType TAG_SHIFT = 8;
+
+	/**< The tag increment. Tags get incremented each time the component we point to is deleted. NOTE THE TAG IS PERSISTENT ACROSS REUSES TO DETECT GARBAGE. */
+	static const StateType TAG_ONE = static_cast< StateType >( 1 ) << TAG_SHIFT;
 
 	/**< Component state flags. */
-	typedef uint8_t FlagType;
-	FlagType _flags;
+	typedef StateType FlagType;
 	
 	/**< State flag names, */
 	enum StateFlags : FlagType { 
 		IS_ACTIVE = 1, // Is the component active
 		PENDING_ACTIVE = 2, // Should we make the component active
 		PENDING_SLEEP = 4, // Should we make the component sleep
-		PENDING_DELETE = 8 // Should we delete the component
+		PENDING_DELETE = 8, // Should we delete the component
+		PENDING_CREATE = 16 // Is the component waiting to be constructed
 	};
+
+	/**< All flag bits. */
+	static const FlagType FLAG_MASK = TAG_ONE - 1;
+
+	/**< All flags that mark a control block as having pending changes. */
+	static const FlagType PENDING_MASK = PENDING_ACTIVE | PENDING_SLEEP | PENDING_DELETE | PENDING_CREATE;
 };
\ No newline at end of file
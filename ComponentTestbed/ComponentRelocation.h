@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+*	Checks if components of the given type can be moved to another address by copying their bytes.
+*
+*	Relocating such a component copies it with memcpy and never runs its move constructor or destructor. Trivially 
+*	copyable types are trivially relocatable. Other types opt in by specializing the check:
+*
+*		template <>
+*		struct IsComponentTriviallyRelocatable<Mesh> : std::true_type { };
+*
+*	Only opt in types that do not point into themselves or register their address anywhere. Some standard 
+*	library types do (EG: std::string with a small string buffer), so components holding them must not opt in.
+*/
+template <typename ComponentType>
+struct IsComponentTriviallyRelocatable : std::integral_constant<bool, std::is_trivially_copyable<ComponentType>::value> { };
+
+/**
+*	Relocates and swaps components with their move operations.
+*/
+template <typename ComponentType, bool TRIVIAL = IsComponentTriviallyRelocatable<ComponentType>::value>
+struct ComponentRelocation
+{
+	/**
+	*	Moves a component into uninitialized storage, leaving its old storage uninitialized.
+	*/
+	static inline void Relocate( ComponentType *source, ComponentType *target ) _NOEXCEPT
+	{
+		new ( target ) ComponentType( std::move( *source ) );
+		source->~ComponentType( );
+	}
+
+	/**
+	*	Swaps two components.
+	*/
+	static inline void Swap( ComponentType &a, ComponentType &b ) _NOEXCEPT
+	{
+		using std::swap;
+		swap( a, b );
+	}
+};
+
+/**
+*	Relocates and swaps trivially relocatable components by copying their bytes.
+*/
+template <typename ComponentType>
+struct ComponentRelocation<ComponentType, true>
+{
+	/**
+	*	Moves a component into uninitialized storage, leaving its old storage uninitialized.
+	*/
+	static inline void Relocate( ComponentType *source, ComponentType *target ) _NOEXCEPT
+	{
+		std::memcpy( static_cast< void* >( target ), static_cast< const void* >( source ), sizeof( ComponentType ) );
+	}
+
+	/**
+	*	Swaps two components through a buffer on the stack.
+	*/
+	static inline void Swap( ComponentType &a, ComponentType &b ) _NOEXCEPT
+	{
+		unsigned char buffer [ sizeof( ComponentType ) ];
+		std::memcpy( buffer, static_cast< const void* >( std::addressof( a ) ), sizeof( ComponentType ) );
+		std::memcpy( static_cast< void* >( std::addressof( a ) ), static_cast< const void* >( std::addressof( b ) ), sizeof( ComponentType ) );
+		std::memcpy( static_cast< void* >( std::addressof( b ) ), buffer, sizeof( ComponentType ) );
+	}
+};
\ No newline at end of file
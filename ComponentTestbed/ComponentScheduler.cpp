@@ -0,0 +1,187 @@
+#include "stdafx.h"
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ComponentScheduler.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+ComponentScheduler::ComponentScheduler( )
+	: _stages_dirty( true )
+{
+
+}
+
+ComponentScheduler::~ComponentScheduler( )
+{
+
+}
+
+ComponentScheduler::PoolId ComponentScheduler::Register( std::unique_ptr<ComponentSchedulerPool> pool )
+{
+	if ( !pool )
+		throw std::runtime_error( "Tried to register a null pool with the scheduler." );
+
+	// Make room for the pool everywhere before registering it (may throw)
+	const auto id = _pools.size( );
+	_pools.reserve( id + 1 );
+	_reads.reserve( id + 1 );
+	_writes.reserve( id + 1 );
+	std::vector<PoolId> writes( 1, id );
+
+	// Every pool writes itself
+	_pools.push_back( std::move( pool ) );
+	_reads.push_back( std::vector<PoolId>( ) );
+	_writes.push_back( std::move( writes ) );
+	_stages_dirty = true;
+
+	return id;
+}
+
+void ComponentScheduler::InsertPool( std::vector<PoolId> &pools, PoolId pool )
+{
+	const auto position = std::lower_bound( pools.begin( ), pools.end( ), pool );
+	if ( position == pools.end( ) || *position != pool )
+		pools.insert( position, pool );
+}
+
+bool ComponentScheduler::Intersects( const std::vector<PoolId> &lhs, const std::vector<PoolId> &rhs )
+{
+	auto l = lhs.begin( );
+	auto r = rhs.begin( );
+	while ( l != lhs.end( ) && r != rhs.end( ) )
+	{
+		if ( *l < *r )
+			++l;
+		else if ( *r < *l )
+			++r;
+		else
+			return true;
+	}
+
+	return false;
+}
+
+void ComponentScheduler::Reads( PoolId pool, PoolId dependency )
+{
+	CheckPool( pool );
+	CheckPool( dependency );
+
+	InsertPool( _reads [ pool ], dependency );
+	_stages_dirty = true;
+}
+
+void ComponentScheduler::Writes( PoolId pool, PoolId dependency )
+{
+	CheckPool( pool );
+	CheckPool( dependency );
+
+	InsertPool( _writes [ pool ], dependency );
+	_stages_dirty = true;
+}
+
+void ComponentScheduler::Update( const float dt )
+{
+	BuildStages( );
+
+	for ( const auto pool : _stage_pools )
+		_pools [ pool ]->Update( dt );
+}
+
+void ComponentScheduler::LateUpdate( )
+{
+	// Keep the first failure so the remaining pools still get their changes applied
+	std::exception_ptr exception;
+
+	for ( auto &pool : _pools )
+	{
+		try
+		{
+			pool->LateUpdate( );
+		}
+		catch ( ... )
+		{
+			if ( !exception )
+				exception = std::current_exception( );
+		}
+	}
+
+	if ( exception )
+		std::rethrow_exception( exception );
+}
+
+size_t ComponentScheduler::GetNumStages( )
+{
+	BuildStages( );
+	return _stage_offsets.size( ) - 1;
+}
+
+void ComponentScheduler::CheckPool( PoolId pool ) const
+{
+	if ( pool >= _pools.size( ) )
+		throw std::runtime_error( "Pool was not registered with the scheduler." );
+}
+
+bool ComponentScheduler::Conflicts( PoolId lhs, PoolId rhs ) const
+{
+	return Intersects( _writes [ lhs ], _writes [ rhs ] ) || Intersects( _writes [ lhs ], _reads [ rhs ] ) || Intersects( _reads [ lhs ], _writes [ rhs ] );
+}
+
+void ComponentScheduler::BuildStages( )
+{
+	if ( !_stages_dirty )
+		return;
+
+	// Each pool goes in the stage after the last earlier pool it conflicts with
+	std::vector<size_t> stages( _pools.size( ), 0 );
+	size_t num_stages = 0;
+	for ( PoolId pool = 0; pool < _pools.size( ); pool++ )
+	{
+		for ( PoolId earlier = 0; earlier < pool; earlier++ )
+		{
+			if ( stages [ earlier ] >= stages [ pool ] && Conflicts( earlier, pool ) )
+				stages [ pool ] = stages [ earlier ] + 1;
+		}
+
+		num_stages = std::max( num_stages, stages [ pool ] + 1 );
+	}
+
+	// Lay the stages out one after the other, keeping registration order within a stage
+	_stage_offsets.assign( num_stages + 1, 0 );
+	for ( const auto stage : stages )
+		_stage_offsets [ stage + 1 ]++;
+	for ( size_t stage = 0; stage < num_stages; stage++ )
+		_stage_offsets [ stage + 1 ] += _stage_offsets [ stage ];
+
+	_stage_pools.resize( _pools.size( ) );
+	std::vector<size_t> cursors( _stage_offsets.begin( ), _stage_offsets.end( ) - 1 );
+	for ( PoolId pool = 0; pool < _pools.size( ); pool++ )
+		_stage_pools [ cursors [ stages [ pool ] ]++ ] = pool;
+
+	_stages_dirty = false;
+}
\ No newline at end of file
@@ -0,0 +1,252 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "ComponentPool.h"
+
+/**
+*	The type erased interface the scheduler drives component pools through.
+*/
+class ComponentSchedulerPool
+{
+public:
+
+	virtual ~ComponentSchedulerPool( ) { }
+
+	/**
+	*	Updates all active components of the pool.
+	*/
+	virtual void Update( const float dt ) = 0;
+
+	/**
+	*	Applies pending changes to the pool.
+	*/
+	virtual void LateUpdate( ) = 0;
+};
+
+/**
+*	Drives a component pool of a given type for the scheduler.
+*/
+template <typename ComponentType, typename Traits>
+class ComponentSchedulerPoolAdapter final : public ComponentSchedulerPool
+{
+public:
+
+	/**
+	*	Constructs an adapter for the given pool, which must outlive the adapter.
+	*/
+	inline explicit ComponentSchedulerPoolAdapter( ComponentPool<ComponentType, Traits> &pool )
+		: _pool( pool )
+	{
+
+	}
+
+	inline void Update( const float dt ) override { _pool.Update( dt ); }
+
+	inline void LateUpdate( ) override { _pool.LateUpdate( ); }
+
+private:
+
+	/**< The driven pool. */
+	ComponentPool<ComponentType, Traits> &_pool;
+};
+
+/**
+*	Updates many component pools of different types, running the updates of independent pools concurrently.
+*
+*	Pools declare which other pools their components read and write while they update, and every pool writes itself.
+*	Two pools conflict if either writes a pool the other reads or writes. Conflicting pools update in the order they 
+*	were registered, so the conflicts form a graph without cycles. The scheduler splits that graph into stages, where 
+*	each pool goes in the stage after the last pool it has to wait for, and every stage runs as one batch of jobs.
+*
+*	Once every stage has run, LateUpdate applies the pending changes of every pool in the order they were registered. 
+*	The pools must outlive the scheduler, and like the pools it must only be used from the thread that owns them.
+*/
+class ComponentScheduler final
+{
+public:
+
+	/**< Names a pool registered with the scheduler. */
+	typedef size_t PoolId;
+
+	/**
+	*	Constructs a scheduler with no pools.
+	*/
+	ComponentScheduler( );
+
+	/**
+	*	Destroys the scheduler, leaving the pools alone.
+	*/
+	~ComponentScheduler( );
+
+	/**
+	*	Scheduler copying is forbidden.
+	*/
+	ComponentScheduler( ComponentScheduler const& ) = delete;
+
+	/**
+	*	Scheduler copying is forbidden.
+	*/
+	ComponentScheduler& operator=( ComponentScheduler const& ) = delete;
+
+	/**
+	*	Registers a pool with the scheduler.
+	*
+	*	@param pool the pool to update, which must not already be registered
+	*	@returns the id of the pool for declaring dependencies
+	*/
+	template <typename ComponentType, typename Traits>
+	inline PoolId Register( ComponentPool<ComponentType, Traits> &pool )
+	{
+		std::unique_ptr<ComponentSchedulerPool> adapter( new ComponentSchedulerPoolAdapter<ComponentType, Traits>( pool ) );
+		return Register( std::move( adapter ) );
+	}
+
+	/**
+	*	Registers a pool behind the type erased interface.
+	*
+	*	@param pool the pool to update
+	*	@returns the id of the pool for declaring dependencies
+	*/
+	PoolId Register( std::unique_ptr<ComponentSchedulerPool> pool );
+
+	/**
+	*	Declares that updating a pool reads the components of another pool.
+	*
+	*	@param pool the pool whose updates read
+	*	@param dependency the pool that is read
+	*/
+	void Reads( PoolId pool, PoolId dependency );
+
+	/**
+	*	Declares that updating a pool changes the components of another pool.
+	*
+	*	@param pool the pool whose updates write
+	*	@param dependency the pool that is written
+	*/
+	void Writes( PoolId pool, PoolId dependency );
+
+	/**
+	*	Updates every pool on the calling thread, in the order of the stages.
+	*
+	*	@param dt the time since the last frame
+	*/
+	void Update( const float dt );
+
+	/**
+	*	Updates every pool, running the pools of each stage concurrently across the executor.
+	*
+	*	Executors must provide Run( num_jobs, job ) as for ComponentPool::ParallelUpdate. If an update throws, the stages
+	*	after it are not run and the exception is passed on.
+	*
+	*	@param dt the time since the last frame
+	*	@param executor the executor to run the stages on
+	*/
+	template <typename Executor>
+	inline void Update( const float dt, Executor &executor )
+	{
+		BuildStages( );
+
+		for ( size_t stage = 0; stage + 1 < _stage_offsets.size( ); stage++ )
+		{
+			const auto *const pools = _stage_pools.data( ) + _stage_offsets [ stage ];
+			const auto num_pools = _stage_offsets [ stage + 1 ] - _stage_offsets [ stage ];
+
+			// A stage of one pool needs no other threads
+			if ( num_pools == 1 )
+			{
+				_pools [ pools [ 0 ] ]->Update( dt );
+				continue;
+			}
+
+			executor.Run( num_pools, [ this, pools, dt ] ( size_t job )
+			{
+				_pools [ pools [ job ] ]->Update( dt );
+			} );
+		}
+	}
+
+	/**
+	*	Applies the pending changes of every pool in the order they were registered.
+	*
+	*	Every pool is late updated even if some throw, and the first exception is passed on afterwards.
+	*/
+	void LateUpdate( );
+
+	/**
+	*	Gets the number of stages the pool updates are split into.
+	*/
+	size_t GetNumStages( );
+
+private:
+
+	/**
+	*	Throws if the id does not name a registered pool.
+	*/
+	void CheckPool( PoolId pool ) const;
+
+	/**
+	*	Adds a pool to a sorted set of pools, unless it is there already.
+	*/
+	static void InsertPool( std::vector<PoolId> &pools, PoolId pool );
+
+	/**
+	*	Checks if two sorted sets of pools share a pool.
+	*/
+	static bool Intersects( const std::vector<PoolId> &lhs, const std::vector<PoolId> &rhs );
+
+	/**
+	*	Checks if two pools must not update at the same time.
+	*/
+	bool Conflicts( PoolId lhs, PoolId rhs ) const;
+
+	/**
+	*	Splits the pools into stages if the pools or their dependencies changed since the stages were last built.
+	*/
+	void BuildStages( );
+
+	/**< The registered pools. */
+	std::vector<std::unique_ptr<ComponentSchedulerPool>> _pools;
+
+	/**< The pools each pool reads, sorted. */
+	std::vector<std::vector<PoolId>> _reads;
+
+	/**< The pools each pool writes, including itself, sorted. */
+	std::vector<std::vector<PoolId>> _writes;
+
+	/**< The pools of every stage, one stage after the other. */
+	std::vector<PoolId> _stage_pools;
+
+	/**< Where each stage starts in the stage pools, followed by the number of stage pools. */
+	std::vector<size_t> _stage_offsets;
+
+	/**< Whether the stages need rebuilding. */
+	bool _stages_dirty;
+};
\ No newline at end of file
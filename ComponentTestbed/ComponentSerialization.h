@@ -0,0 +1,134 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+/**
+*	Binary snapshots of component pools (see ComponentPool::Serialize).
+*
+*	Pools write to any writer providing Write( const void *data, size_t size ) and read from any reader providing
+*	Read( void *data, size_t size ), which must throw if it cannot produce all of the requested bytes. Snapshots are
+*	raw memory, so they can only be restored by builds with the same component layout and byte order.
+*
+*	A snapshot is laid out as:
+*
+*		uint32_t magic, uint32_t version
+*		uint64_t component size, uint64_t component count, uint64_t sleeping component count, uint64_t control block count
+*		uint64_t garbage tag of every control block
+*		IndexType control block index of every component
+*		the raw components, sleeping block first
+*/
+struct ComponentPoolSnapshot
+{
+	/**< Identifies component pool snapshots. */
+	static const uint32_t MAGIC = 0x50504f43; // "COPP"
+
+	/**< The snapshot layout version, bumped whenever the layout changes. */
+	static const uint32_t VERSION = 1;
+};
+
+/**
+*	Writes snapshots into a growable byte buffer.
+*/
+class ComponentBufferWriter final
+{
+public:
+
+	/**
+	*	Constructs a writer that appends to the given buffer.
+	*/
+	inline explicit ComponentBufferWriter( std::vector<unsigned char> &buffer )
+		: _buffer( buffer )
+	{
+
+	}
+
+	/**
+	*	Appends the given bytes to the buffer.
+	*/
+	inline void Write( const void *data, size_t size )
+	{
+		const auto *bytes = static_cast< const unsigned char* >( data );
+		_buffer.insert( _buffer.end( ), bytes, bytes + size );
+	}
+
+private:
+
+	/**< The buffer being written to. */
+	std::vector<unsigned char> &_buffer;
+};
+
+/**
+*	Reads snapshots out of a byte buffer.
+*/
+class ComponentBufferReader final
+{
+public:
+
+	/**
+	*	Constructs a reader over the given bytes, which must outlive the reader.
+	*/
+	inline ComponentBufferReader( const void *data, size_t size )
+		: _data( static_cast< const unsigned char* >( data ) )
+		, _remaining( size )
+	{
+
+	}
+
+	/**
+	*	Copies the next bytes of the buffer out.
+	*/
+	inline void Read( void *data, size_t size )
+	{
+		if ( size > _remaining )
+			throw std::runtime_error( "Tried to read past the end of the snapshot." );
+
+		std::memcpy( data, _data, size );
+		_data += size;
+		_remaining -= size;
+	}
+
+	/**
+	*	Gets the number of bytes left to read.
+	*/
+	inline size_t Remaining( ) const
+	{
+		return _remaining;
+	}
+
+private:
+
+	/**< The next byte to read. */
+	const unsigned char *_data;
+
+	/**< The number of bytes left to read. */
+	size_t _remaining;
+};
\ No newline at end of file
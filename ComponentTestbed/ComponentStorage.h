@@ -0,0 +1,272 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "ChunkedArray.h"
+#include "ComponentPrefetch.h"
+#include "ComponentRelocation.h"
+
+/**
+*	Checks if the component type provides static void UpdateBatch( ComponentType *components, size_t count, float dt ).
+*/
+template <typename ComponentType>
+struct HasComponentUpdateBatch
+{
+private:
+
+	template <typename Type, void( *)( Type*, size_t, float )>
+	struct Check;
+
+	template <typename Type>
+	static char Test( Check<Type, &Type::UpdateBatch>* );
+
+	template <typename Type>
+	static long Test( ... );
+
+public:
+
+	static const bool value = sizeof( Test<ComponentType>( nullptr ) ) == sizeof( char );
+};
+
+/**
+*	Stores whole components in contiguous chunks (array of structures).
+*
+*	This is the default component storage. Component pools call Update( dt ) on each component, unless the 
+*	component type provides a static UpdateBatch( components, count, dt ) in which case it is handed each 
+*	contiguous run of active components instead. Runs that start a chunk start on a cache line, other runs 
+*	start wherever the active block does, so batch kernels must handle unaligned heads and scalar tails.
+*
+*	Components that are trivially relocatable (see IsComponentTriviallyRelocatable) are moved and swapped by copying 
+*	their bytes, and components that are trivially destructible are never visited to destroy them.
+*/
+template <typename ComponentType, size_t CHUNK_SIZE>
+class ComponentStorage
+{
+	// Assert assumptions over component type
+	static_assert( std::is_nothrow_move_constructible<ComponentType>::value, "Component classes must be nothrow move constructible." );
+	static_assert( std::is_nothrow_move_assignable<ComponentType>::value, "Component classes must be nothrow move assignable." );
+	static_assert( std::is_nothrow_destructible<ComponentType>::value, "Component classes must be nothrow destructible." );
+
+public:
+
+	/**
+	*	Constructs empty component storage.
+	*
+	*	@param resource the memory resource to allocate chunks from, null for the global operator new
+	*/
+	inline explicit ComponentStorage( ComponentMemoryResource *resource = nullptr )
+		: _components( resource )
+	{
+
+	}
+
+	/**
+	*	Ensures we have storage for at least the given amount of components.
+	*/
+	inline void Reserve( size_t capacity ) { _components.Reserve( capacity ); }
+
+	/**
+	*	Gets the number of components we currently have storage for.
+	*/
+	inline size_t Capacity( ) const { return _components.Capacity( ); }
+
+	/**
+	*	Adds storage owned by someone else as the next chunk of component slots (see ChunkedArray::AdoptChunk).
+	*/
+	inline void AdoptChunk( ComponentType *chunk ) { _components.AdoptChunk( chunk ); }
+
+	/**
+	*	Constructs a component in the given uninitialized slot.
+	*
+	*	@param index the slot to construct the component in
+	*	@param args the constructor arguments for the component
+	*/
+	template <typename... Args>
+	inline void Construct( size_t index, Args &&... args )
+	{
+		new ( Address( index ) ) ComponentType( std::forward<Args>( args )... );
+	}
+
+	/**
+	*	Destroys the component in the given slot, leaving the slot uninitialized.
+	*/
+	inline void Destroy( size_t index ) { _components [ index ].~ComponentType( ); }
+
+	/**
+	*	Moves a component into an uninitialized slot, leaving its old slot uninitialized.
+	*/
+	inline void Relocate( size_t loc_index, size_t target_index )
+	{
+		ComponentRelocation<ComponentType>::Relocate( Address( loc_index ), Address( target_index ) );
+	}
+
+	/**
+	*	Swaps the components in two slots.
+	*/
+	inline void Swap( size_t loc_index, size_t target_index )
+	{
+		ComponentRelocation<ComponentType>::Swap( _components [ loc_index ], _components [ target_index ] );
+	}
+
+	/**
+	*	Destroys the components in the given slot range, leaving the slots uninitialized.
+	*/
+	inline void DestroyRange( size_t begin, size_t end )
+	{
+		DestroySpans( begin, end, std::integral_constant<bool, std::is_trivially_destructible<ComponentType>::value>( ) );
+	}
+
+	/**
+	*	Gets the address control blocks hand out for the component in the given slot.
+	*/
+	inline ComponentType* Address( size_t index ) { return std::addressof( _components [ index ] ); }
+
+	/**
+	*	Calls fn( components, count ) for each contiguous run of components in the given slot range.
+	*/
+	template <typename Function>
+	inline void ForEachSpan( size_t begin, size_t end, Function fn ) const { _components.ForEachSpan( begin, end, fn ); }
+
+	/**
+	*	Gets the lookups into the components for component references.
+	*/
+	inline const ChunkedArrayView<ComponentType>* GetView( ) const { return &_components; }
+
+	/**
+	*	Gets the component in the given slot.
+	*/
+	inline ComponentType& operator[]( size_t index ) { return _components [ index ]; }
+
+	/**
+	*	Hints that the component in the given slot will be used soon.
+	*/
+	inline void Prefetch( size_t index ) const { COMPONENT_PREFETCH( std::addressof( _components [ index ] ) ); }
+
+	/**
+	*	Updates the components in the given slot range.
+	*/
+	inline void Update( size_t begin, size_t end, const float dt )
+	{
+		UpdateSpans( begin, end, dt, std::integral_constant<bool, HasComponentUpdateBatch<ComponentType>::value>( ) );
+	}
+
+	/**
+	*	Writes the raw bytes of the components in the slot range [0, count) to the writer.
+	*/
+	template <typename Writer>
+	inline void Write( Writer &writer, size_t count ) const
+	{
+		static_assert( std::is_trivially_copyable<ComponentType>::value, "Only trivially copyable components can be serialized." );
+
+		_components.ForEachSpan( 0, count, [ &writer ] ( const ComponentType *components, size_t num_components )
+		{
+			writer.Write( components, num_components * sizeof( ComponentType ) );
+		} );
+	}
+
+	/**
+	*	Reads the raw bytes of components written by Write into the uninitialized slot range [0, count).
+	*/
+	template <typename Reader>
+	inline void Read( Reader &reader, size_t count )
+	{
+		static_assert( std::is_trivially_copyable<ComponentType>::value, "Only trivially copyable components can be serialized." );
+
+		_components.ForEachSpan( 0, count, [ &reader ] ( ComponentType *components, size_t num_components )
+		{
+			reader.Read( components, num_components * sizeof( ComponentType ) );
+		} );
+	}
+
+	/**
+	*	Rounds the given batch size up so a batch of components spans a whole number of cache lines.
+	*
+	*	Chunks start on a cache line, so batches aligned to multiples of the batch size never share a cache line.
+	*/
+	static inline size_t AlignBatchSize( size_t batch_size )
+	{
+		const size_t cache_line_size = ChunkedArray<ComponentType, CHUNK_SIZE>::CACHE_LINE_SIZE;
+
+		if ( batch_size > CHUNK_SIZE )
+			batch_size = CHUNK_SIZE;
+		while ( batch_size < CHUNK_SIZE && ( batch_size * sizeof( ComponentType ) ) % cache_line_size != 0 )
+			batch_size *= 2;
+
+		return batch_size;
+	}
+
+private:
+
+	/**
+	*	Updates the components in the given slot range with the batch update of the component type.
+	*/
+	inline void UpdateSpans( size_t begin, size_t end, const float dt, std::true_type )
+	{
+		// Hand each contiguous chunk over in one go
+		_components.ForEachSpan( begin, end, [ dt ] ( ComponentType *components, size_t count )
+		{
+			ComponentType::UpdateBatch( components, count, dt );
+		} );
+	}
+
+	/**
+	*	Updates the components in the given slot range one component at a time.
+	*/
+	inline void UpdateSpans( size_t begin, size_t end, const float dt, std::false_type )
+	{
+		// Walk the range one contiguous chunk at a time
+		_components.ForEachSpan( begin, end, [ dt ] ( ComponentType *components, size_t count )
+		{
+			for ( size_t i = 0; i < count; i++ )
+				components [ i ].Update( dt );
+		} );
+	}
+
+	/**
+	*	Trivially destructible components need nothing done to destroy them.
+	*/
+	inline void DestroySpans( size_t, size_t, std::true_type ) { }
+
+	/**
+	*	Destroys the components in the given slot range one at a time.
+	*/
+	inline void DestroySpans( size_t begin, size_t end, std::false_type )
+	{
+		_components.ForEachSpan( begin, end, [ ] ( ComponentType *components, size_t count )
+		{
+			for ( size_t i = 0; i < count; i++ )
+				components [ i ].~ComponentType( );
+		} );
+	}
+
+	/**< The component slots. */
+	ChunkedArray<ComponentType, CHUNK_SIZE> _components;
+};
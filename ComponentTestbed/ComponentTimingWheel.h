@@ -0,0 +1,159 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+*	A hashed timing wheel of frame timers.
+*
+*	Timers are kept in one bucket per frame slot of the wheel, so advancing a frame only visits the bucket that 
+*	is due. Timers further away than one turn of the wheel wait in their bucket for the turns they have left.
+*
+*	Timers cannot be cancelled. Owners tell stale timers apart by the ticket they scheduled them with.
+*/
+template <size_t WHEEL_SIZE>
+class ComponentTimingWheel final
+{
+	// Bucket lookup relies on cheap division
+	static_assert( WHEEL_SIZE > 0 && ( WHEEL_SIZE & ( WHEEL_SIZE - 1 ) ) == 0, "Timing wheel size must be a power of two." );
+
+public:
+
+	/**
+	*	Constructs an empty timing wheel.
+	*/
+	inline ComponentTimingWheel( )
+		: _buckets( WHEEL_SIZE )
+		, _frame( 0 )
+		, _size( 0 )
+	{
+
+	}
+
+	/**
+	*	Schedules a timer.
+	*
+	*	@param key the key handed back once the timer is due
+	*	@param ticket the ticket handed back once the timer is due
+	*	@param num_frames the number of frame advances until the timer is due, at least one
+	*/
+	inline void Schedule( uint32_t key, uint32_t ticket, uint64_t num_frames )
+	{
+		// Timers are never due on the frame they were scheduled
+		num_frames = num_frames > 0 ? num_frames : 1;
+
+		const Timer timer = { key, ticket, ( num_frames - 1 ) / WHEEL_SIZE };
+		_buckets [ ( _frame + num_frames ) % WHEEL_SIZE ].push_back( timer );
+		++_size;
+	}
+
+	/**
+	*	Moves to the next frame and hands out the timers that are due.
+	*
+	*	The due timers are taken out of the wheel before any are handed out, so the function may schedule new timers.
+	*
+	*	@param fn the function to call as fn( key, ticket ) for each due timer
+	*/
+	template <typename Function>
+	inline void Advance( Function fn )
+	{
+		auto &bucket = _buckets [ ++_frame % WHEEL_SIZE ];
+
+		// Keep the timers with turns left in the bucket and take the rest out
+		_due.clear( );
+		size_t num_waiting = 0;
+		for ( auto &timer : bucket )
+		{
+			if ( timer._turns > 0 )
+			{
+				--timer._turns;
+				bucket [ num_waiting++ ] = timer;
+			}
+			else
+			{
+				_due.push_back( timer );
+			}
+		}
+		bucket.resize( num_waiting );
+		_size -= _due.size( );
+
+		for ( const auto &timer : _due )
+			fn( timer._key, timer._ticket );
+	}
+
+	/**
+	*	Drops every timer.
+	*/
+	inline void Clear( )
+	{
+		for ( auto &bucket : _buckets )
+			bucket.clear( );
+
+		_size = 0;
+	}
+
+	/**
+	*	Gets the number of frames the wheel has advanced.
+	*/
+	inline uint64_t GetFrame( ) const { return _frame; }
+
+	/**
+	*	Gets the number of scheduled timers, including stale ones.
+	*/
+	inline size_t Size( ) const { return _size; }
+
+private:
+
+	/**
+	*	A scheduled timer.
+	*/
+	struct Timer
+	{
+		/**< The key handed back once the timer is due. */
+		uint32_t _key;
+
+		/**< The ticket handed back once the timer is due. */
+		uint32_t _ticket;
+
+		/**< The number of turns of the wheel left before the timer is due. */
+		uint64_t _turns;
+	};
+
+	/**< The timers of each frame slot. */
+	std::vector<std::vector<Timer>> _buckets;
+
+	/**< The timers that are due on the current advance, kept to reuse its storage. */
+	std::vector<Timer> _due;
+
+	/**< The number of frames the wheel has advanced. */
+	uint64_t _frame;
+
+	/**< The number of scheduled timers. */
+	size_t _size;
+};
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdexcept>
+
+/**
+*	Compile time switches for component pool validation.
+*
+*	Define COMPONENT_POOL_VALIDATION to 1 to have unchecked accessors check their preconditions and to have every 
+*	component pool check its invariants at the end of each LateUpdate (see ComponentPool::Validate). It defaults to 
+*	on in debug builds and off otherwise, so release builds pay nothing for it. Failures throw std::logic_error.
+*
+*	COMPONENT_POOL_UNLIKELY( condition ) marks a branch condition as rarely true where the compiler supports it.
+*/
+#ifndef COMPONENT_POOL_VALIDATION
+#ifdef _DEBUG
+#define COMPONENT_POOL_VALIDATION 1
+#else
+#define COMPONENT_POOL_VALIDATION 0
+#endif
+#endif
+
+#ifndef COMPONENT_POOL_UNLIKELY
+#if defined( __GNUC__ )
+#define COMPONENT_POOL_UNLIKELY( condition ) __builtin_expect( !!( condition ), 0 )
+#else
+#define COMPONENT_POOL_UNLIKELY( condition ) ( condition )
+#endif
+#endif
+
+#if COMPONENT_POOL_VALIDATION
+#define COMPONENT_POOL_ASSERT( condition, message ) do { if ( COMPONENT_POOL_UNLIKELY( !( condition ) ) ) throw std::logic_error( message ); } while ( false )
+#define COMPONENT_POOL_VALIDATE( statement ) statement
+#else
+#define COMPONENT_POOL_ASSERT( condition, message ) do { } while ( false )
+#define COMPONENT_POOL_VALIDATE( statement )
+#endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "stdafx.h"
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ComponentWorkerPool.h"
+
+ComponentWorkerPool::ComponentWorkerPool( size_t num_threads )
+	: _job( nullptr )
+	, _num_jobs( 0 )
+	, _next_job( 0 )
+	, _num_completed( 0 )
+	, _num_active( 0 )
+	, _generation( 0 )
+	, _shutdown( false )
+{
+	_threads.reserve( num_threads );
+	for ( size_t i = 0; i < num_threads; i++ )
+		_threads.emplace_back( &ComponentWorkerPool::WorkerMain, this );
+}
+
+ComponentWorkerPool::~ComponentWorkerPool( )
+{
+	// Tell the workers to stop
+	{
+		std::lock_guard<std::mutex> lock( _mutex );
+		_shutdown = true;
+	}
+	_work_available.notify_all( );
+
+	for ( auto &thread : _threads )
+		thread.join( );
+}
+
+void ComponentWorkerPool::Run( size_t num_jobs, const Job &job )
+{
+	// Small batches are not worth waking the workers for
+	if ( _threads.empty( ) || num_jobs <= 1 )
+	{
+		for ( size_t i = 0; i < num_jobs; i++ )
+			job( i );
+		return;
+	}
+
+	// Publish the batch
+	{
+		std::unique_lock<std::mutex> lock( _mutex );
+
+		// Workers that woke up late for the previous batch must leave before we reset the batch state
+		_work_done.wait( lock, [ this ] { return _num_active == 0; } );
+
+		_job = &job;
+		_num_jobs = num_jobs;
+		_next_job = 0;
+		_num_completed = 0;
+		_exception = nullptr;
+		_generation++;
+	}
+	_work_available.notify_all( );
+
+	// Help out with the batch
+	const auto completed = RunJobs( job, num_jobs );
+
+	// Wait for the rest of the batch to complete
+	std::exception_ptr exception;
+	{
+		std::unique_lock<std::mutex> lock( _mutex );
+
+		_num_completed += completed;
+		_work_done.wait( lock, [ this ] { return _num_completed == _num_jobs; } );
+
+		// The batch is over, late workers must not touch the job
+		_job = nullptr;
+		std::swap( exception, _exception );
+	}
+
+	if ( exception )
+		std::rethrow_exception( exception );
+}
+
+size_t ComponentWorkerPool::NumThreads( ) const
+{
+	return _threads.size( );
+}
+
+size_t ComponentWorkerPool::DefaultThreadCount( )
+{
+	const size_t hardware_threads = std::thread::hardware_concurrency( );
+	return hardware_threads > 1 ? hardware_threads - 1 : 0;
+}
+
+void ComponentWorkerPool::WorkerMain( )
+{
+	size_t generation = 0;
+
+	for ( ;; )
+	{
+		std::unique_lock<std::mutex> lock( _mutex );
+
+		// Wait for a batch we have not seen yet
+		_work_available.wait( lock, [ this, generation ] { return _shutdown || _generation != generation; } );
+		if ( _shutdown )
+			return;
+
+		generation = _generation;
+
+		// The batch may already be over if we woke up late
+		if ( !_job )
+			continue;
+
+		const auto &job = *_job;
+		const auto num_jobs = _num_jobs;
+		_num_active++;
+
+		lock.unlock( );
+		const auto completed = RunJobs( job, num_jobs );
+		lock.lock( );
+
+		_num_active--;
+		_num_completed += completed;
+
+		lock.unlock( );
+		_work_done.notify_all( );
+	}
+}
+
+size_t ComponentWorkerPool::RunJobs( const Job &job, size_t num_jobs )
+{
+	size_t completed = 0;
+
+	// Grab jobs until they run out
+	for ( auto i = _next_job++; i < num_jobs; i = _next_job++ )
+	{
+		try
+		{
+			job( i );
+		}
+		catch ( ... )
+		{
+			// Keep the first exception for the caller of Run
+			std::lock_guard<std::mutex> lock( _mutex );
+			if ( !_exception )
+				_exception = std::current_exception( );
+		}
+
+		completed++;
+	}
+
+	return completed;
+}
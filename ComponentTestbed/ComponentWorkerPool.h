@@ -0,0 +1,140 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+*	A basic pool of worker threads for running batches of jobs.
+*
+*	Satisfies the executor requirements of ComponentPool::ParallelUpdate. The calling thread helps run 
+*	jobs and Run only returns once every job of the batch has completed.
+*/
+class ComponentWorkerPool final
+{
+public:
+
+	/**< A job that gets given the index of the job in its batch. */
+	typedef std::function<void( size_t )> Job;
+
+	/**
+	*	Starts the worker threads.
+	*
+	*	@param num_threads the number of worker threads to start in addition to the calling thread
+	*/
+	explicit ComponentWorkerPool( size_t num_threads = DefaultThreadCount( ) );
+
+	/**
+	*	Stops and joins the worker threads.
+	*/
+	~ComponentWorkerPool( );
+
+	/**
+	*	Worker pool copying is forbidden.
+	*/
+	ComponentWorkerPool( ComponentWorkerPool const& ) = delete;
+
+	/**
+	*	Worker pool copying is forbidden.
+	*/
+	ComponentWorkerPool& operator=( ComponentWorkerPool const& ) = delete;
+
+	/**
+	*	Runs a batch of jobs across the worker threads and the calling thread.
+	*
+	*	If any job throws, the first exception is rethrown once the batch has completed. Must not be called from inside a job.
+	*
+	*	@param num_jobs the number of jobs in the batch
+	*	@param job the job to call once for every index in [0, num_jobs)
+	*/
+	void Run( size_t num_jobs, const Job &job );
+
+	/**
+	*	Gets the number of worker threads, not including the calling thread.
+	*/
+	size_t NumThreads( ) const;
+
+	/**
+	*	Gets the default amount of worker threads, which leaves one hardware thread for the calling thread.
+	*/
+	static size_t DefaultThreadCount( );
+
+private:
+
+	/**
+	*	The entry point for worker threads.
+	*/
+	void WorkerMain( );
+
+	/**
+	*	Runs jobs from the current batch until there are none left.
+	*
+	*	@returns the number of jobs that were run
+	*/
+	size_t RunJobs( const Job &job, size_t num_jobs );
+
+	/**< The worker threads. */
+	std::vector<std::thread> _threads;
+
+	/**< Guards the batch state. */
+	std::mutex _mutex;
+
+	/**< Signalled when a new batch is available or we are shutting down. */
+	std::condition_variable _work_available;
+
+	/**< Signalled when a worker finishes with a batch. */
+	std::condition_variable _work_done;
+
+	/**< The job of the current batch. */
+	const Job *_job;
+
+	/**< The number of jobs in the current batch. */
+	size_t _num_jobs;
+
+	/**< The index of the next job to hand out. */
+	std::atomic<size_t> _next_job;
+
+	/**< The number of jobs of the current batch that have completed. */
+	size_t _num_completed;
+
+	/**< The number of worker threads currently working on a batch. */
+	size_t _num_active;
+
+	/**< Incremented for every new batch so workers can tell batches apart. */
+	size_t _generation;
+
+	/**< The first exception thrown by a job of the current batch. */
+	std::exception_ptr _exception;
+
+	/**< Are we shutting down. */
+	bool _shutdown;
+};
@@ -0,0 +1,99 @@
+#include "stdafx.h"
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "ComponentWorld.h"
+
+ComponentWorld::ComponentWorld( ComponentMemoryResource *resource )
+	: _resource( resource )
+{
+
+}
+
+ComponentWorld::~ComponentWorld( )
+{
+
+}
+
+ComponentEntity ComponentWorld::CreateEntity( )
+{
+	// Reuse the slot of a destroyed entity if there is one
+	if ( !_free_indices.empty( ) )
+	{
+		const auto index = _free_indices.back( );
+		_free_indices.pop_back( );
+		return ComponentEntity( index, _generations [ index ] );
+	}
+
+	// Can we create any more entities
+	if ( _generations.size( ) == ComponentEntity::NULL_INDEX )
+		throw std::runtime_error( "Allocation limit reached for entities." );
+
+	// Make sure destroying the entity cannot fail later (may throw)
+	_free_indices.reserve( _generations.size( ) + 1 );
+
+	const auto index = static_cast< uint32_t >( _generations.size( ) );
+	_generations.push_back( 0 );
+	return ComponentEntity( index, 0 );
+}
+
+void ComponentWorld::DestroyEntity( const ComponentEntity &entity )
+{
+	CheckEntity( entity );
+
+	// Delete the components of the entity from every pool
+	const auto index = entity.GetIndex( );
+	for ( auto &pool : _pools )
+		pool->Remove( index );
+
+	// Move the slot to a new generation so the destroyed entity is no longer alive
+	_generations [ index ]++;
+	_free_indices.push_back( index );
+}
+
+bool ComponentWorld::IsAlive( const ComponentEntity &entity ) const
+{
+	// Freed slots have already moved on to the generation of the entity that will reuse them
+	return entity.GetIndex( ) < _generations.size( ) && _generations [ entity.GetIndex( ) ] == entity.GetGeneration( );
+}
+
+void ComponentWorld::Update( const float dt )
+{
+	for ( auto &pool : _pools )
+		pool->Update( dt );
+}
+
+void ComponentWorld::LateUpdate( )
+{
+	for ( auto &pool : _pools )
+		pool->LateUpdate( );
+}
+
+void ComponentWorld::CheckEntity( const ComponentEntity &entity ) const
+{
+	if ( !IsAlive( entity ) )
+		throw std::runtime_error( "Entity was invalid." );
+}
\ No newline at end of file
@@ -0,0 +1,284 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "ComponentEntity.h"
+#include "ComponentWorldPool.h"
+
+/**
+*	Owns one component pool per component type and ties the components of an entity together across pools.
+*
+*	Every pool keeps a sparse set from entity slots to its components, so finding the sibling components of an 
+*	entity costs a couple of array loads per pool rather than a search. Each joins pools by walking the smallest 
+*	pool and testing membership in the others.
+*
+*	Pools are created on first use with ComponentPoolTraits of their component type. Their components must be added
+*	and removed through the world. Like component pools, component worlds must only be used by the thread that owns them,
+*	although the pools themselves may still be handed SetActive calls from other threads.
+*/
+class ComponentWorld final
+{
+public:
+
+	/**
+	*	Constructs an empty component world.
+	*
+	*	@param resource the memory resource the chunks of every pool of the world are allocated from, null for the global 
+	*	operator new. EG: An arena per level that is released once the world is destroyed.
+	*/
+	explicit ComponentWorld( ComponentMemoryResource *resource = nullptr );
+
+	/**
+	*	Destroys the world and all of its components.
+	*/
+	~ComponentWorld( );
+
+	/**
+	*	World copying is forbidden.
+	*/
+	ComponentWorld( ComponentWorld const& ) = delete;
+
+	/**
+	*	World copying is forbidden.
+	*/
+	ComponentWorld& operator=( ComponentWorld const& ) = delete;
+
+	/**
+	*	Creates a new entity with no components.
+	*/
+	ComponentEntity CreateEntity( );
+
+	/**
+	*	Deletes all components of the entity and frees its slot for reuse.
+	*
+	*	Like ComponentPool::Delete, the components themselves go away at the next LateUpdate.
+	*
+	*	@param entity the entity to destroy
+	*/
+	void DestroyEntity( const ComponentEntity &entity );
+
+	/**
+	*	Checks if the entity has been created by this world and not destroyed since.
+	*/
+	bool IsAlive( const ComponentEntity &entity ) const;
+
+	/**
+	*	Updates all active components of every pool, in the order the pools were first used.
+	*
+	*	@param dt the time since the last frame
+	*/
+	void Update( const float dt );
+
+	/**
+	*	Applies pending changes to every pool.
+	*/
+	void LateUpdate( );
+
+	/**
+	*	Creates a component for the entity.
+	*
+	*	@param entity the entity to create the component for, which must not already have one of this type
+	*	@param args the constructor arguments for the component
+	*	@returns the component reference for the component
+	*/
+	template <typename ComponentType, typename... Args>
+	inline ComponentReference<ComponentType> AddComponent( const ComponentEntity &entity, Args &&... args )
+	{
+		CheckEntity( entity );
+		return GetWorldPool<ComponentType>( ).Add( entity, std::forward<Args>( args )... );
+	}
+
+	/**
+	*	Deletes the component of the given type from the entity, if it has one.
+	*
+	*	@param entity the entity to remove the component from
+	*/
+	template <typename ComponentType>
+	inline void RemoveComponent( const ComponentEntity &entity )
+	{
+		CheckEntity( entity );
+
+		auto *const pool = FindWorldPool<ComponentType>( );
+		if ( pool )
+			pool->Remove( entity.GetIndex( ) );
+	}
+
+	/**
+	*	Checks if the entity has a component of the given type.
+	*/
+	template <typename ComponentType>
+	inline bool HasComponent( const ComponentEntity &entity ) const
+	{
+		const auto *const pool = FindWorldPool<ComponentType>( );
+		return IsAlive( entity ) && pool && pool->Contains( entity.GetIndex( ) );
+	}
+
+	/**
+	*	Gets the component of the given type of the entity.
+	*
+	*	The returned pointer is invalidated by the next LateUpdate.
+	*
+	*	@param entity the entity to get the component of
+	*	@returns the component, or null if the entity has no component of this type
+	*/
+	template <typename ComponentType>
+	inline ComponentType* GetComponent( const ComponentEntity &entity )
+	{
+		CheckEntity( entity );
+
+		auto *const pool = FindWorldPool<ComponentType>( );
+		if ( !pool || !pool->Contains( entity.GetIndex( ) ) )
+			return nullptr;
+
+		return pool->At( entity.GetIndex( ) );
+	}
+
+	/**
+	*	Gets the component pool of the given type, creating it if needed.
+	*
+	*	The pool may be used for SetActive and GetHandle, but components must be created and deleted through the world.
+	*/
+	template <typename ComponentType>
+	inline ComponentPool<ComponentType>& GetPool( )
+	{
+		return GetWorldPool<ComponentType>( ).GetPool( );
+	}
+
+	/**
+	*	Calls the function for every entity that has a component of each of the given types.
+	*
+	*	The function is called as function( entity, ComponentTypes&... ). Entities are visited in the dense order of
+	*	the smallest joined pool. The function must not add or remove components of the joined types, which would 
+	*	reorder the pools being walked. Changes to components of other types and active state changes are fine.
+	*
+	*	Components are passed by reference, so the joined pools must keep whole components (see ComponentStorage).
+	*
+	*	@param function the function to call for every joined entity
+	*/
+	template <typename... ComponentTypes, typename Function>
+	inline void Each( Function &&function )
+	{
+		static_assert( sizeof...( ComponentTypes ) > 0, "Each must join at least one component type." );
+
+		Join( function, FindWorldPool<ComponentTypes>( )... );
+	}
+
+private:
+
+	/**
+	*	Throws if the entity is not alive in this world.
+	*/
+	void CheckEntity( const ComponentEntity &entity ) const;
+
+	/**
+	*	Walks the smallest of the given pools and calls the function for entities that are in every pool.
+	*/
+	template <typename Function, typename... Pools>
+	inline void Join( Function &function, Pools *... pools )
+	{
+		const ComponentWorldPoolBase *const bases [ ] = { pools... };
+		const auto num_pools = sizeof...( Pools );
+
+		// No entity can have a component that has never been added
+		const ComponentWorldPoolBase *smallest = nullptr;
+		for ( size_t i = 0; i < num_pools; i++ )
+		{
+			if ( !bases [ i ] )
+				return;
+
+			if ( !smallest || bases [ i ]->Size( ) < smallest->Size( ) )
+				smallest = bases [ i ];
+		}
+
+		const auto &entities = smallest->GetEntities( );
+		for ( size_t i = 0; i < entities.size( ); i++ )
+		{
+			const auto entity = entities [ i ];
+			const auto index = entity.GetIndex( );
+
+			// Skip entities missing a component from any of the other pools
+			bool joined = true;
+			for ( size_t j = 0; j < num_pools && joined; j++ )
+				joined = bases [ j ] == smallest || bases [ j ]->Contains( index );
+
+			if ( joined )
+				function( entity, *pools->At( index )... );
+		}
+	}
+
+	/**
+	*	Gets the world pool of the given component type, or null if no component of the type has been added yet.
+	*/
+	template <typename ComponentType>
+	inline ComponentWorldPool<ComponentType>* FindWorldPool( ) const
+	{
+		const auto pool = _pool_indices.find( std::type_index( typeid( ComponentType ) ) );
+		return pool == _pool_indices.end( ) ? nullptr : static_cast< ComponentWorldPool<ComponentType>* >( _pools [ pool->second ].get( ) );
+	}
+
+	/**
+	*	Gets the world pool of the given component type, creating it if needed.
+	*/
+	template <typename ComponentType>
+	inline ComponentWorldPool<ComponentType>& GetWorldPool( )
+	{
+		auto *pool = FindWorldPool<ComponentType>( );
+		if ( pool )
+			return *pool;
+
+		// Make sure registering the pool cannot fail once it exists (may throw)
+		_pools.reserve( _pools.size( ) + 1 );
+		std::unique_ptr<ComponentWorldPool<ComponentType>> new_pool( new ComponentWorldPool<ComponentType>( _resource ) );
+		pool = new_pool.get( );
+
+		_pool_indices.emplace( std::type_index( typeid( ComponentType ) ), _pools.size( ) );
+		_pools.push_back( std::move( new_pool ) );
+
+		return *pool;
+	}
+
+	/**< The memory resource the chunks of every pool are allocated from, null for the global operator new. */
+	ComponentMemoryResource *_resource;
+
+	/**< The pool of each component type, in the order they were first used. */
+	std::vector<std::unique_ptr<ComponentWorldPoolBase>> _pools;
+
+	/**< Maps component types to their pool. */
+	std::unordered_map<std::type_index, size_t> _pool_indices;
+
+	/**< The current generation of each entity slot. */
+	std::vector<uint32_t> _generations;
+
+	/**< The slots of destroyed entities waiting to be reused. */
+	std::vector<uint32_t> _free_indices;
+};
\ No newline at end of file
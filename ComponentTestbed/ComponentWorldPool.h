@@ -0,0 +1,259 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ComponentEntity.h"
+#include "ComponentPool.h"
+
+/**
+*	The sparse set of entities that have a component of one type in a component world.
+*
+*	The sparse array maps entity slots to positions in the dense array of entities, so membership tests 
+*	are two loads and the members can be walked without gaps. Used by ComponentWorld to join pools.
+*/
+class ComponentWorldPoolBase
+{
+public:
+
+	/**< Marks entity slots that are not in the set. */
+	static const uint32_t NULL_DENSE_INDEX = UINT32_MAX;
+
+	/**
+	*	Destroys the pool.
+	*/
+	virtual ~ComponentWorldPoolBase( ) { }
+
+	/**
+	*	Updates all active components of the pool.
+	*
+	*	@param dt the time since the last frame
+	*/
+	virtual void Update( const float dt ) = 0;
+
+	/**
+	*	Applies pending changes to the components of the pool.
+	*/
+	virtual void LateUpdate( ) = 0;
+
+	/**
+	*	Deletes the component of the entity in the given slot, if the entity has one.
+	*
+	*	@param index the slot of the entity
+	*/
+	virtual void Remove( uint32_t index ) = 0;
+
+	/**
+	*	Checks if the entity in the given slot has a component in the pool.
+	*/
+	inline bool Contains( uint32_t index ) const
+	{
+		return index < _sparse.size( ) && _sparse [ index ] != NULL_DENSE_INDEX;
+	}
+
+	/**
+	*	Gets the number of entities with a component in the pool.
+	*/
+	inline size_t Size( ) const
+	{
+		return _entities.size( );
+	}
+
+	/**
+	*	Gets the entities with a component in the pool, in no particular order.
+	*/
+	inline const std::vector<ComponentEntity>& GetEntities( ) const
+	{
+		return _entities;
+	}
+
+protected:
+
+	/**
+	*	Makes room to insert the entity in the given slot, so that InsertEntity cannot fail.
+	*/
+	inline void ReserveEntity( uint32_t index )
+	{
+		// Pass a copy of the marker as resize takes it by reference
+		if ( index >= _sparse.size( ) )
+			_sparse.resize( index + 1, static_cast< uint32_t >( NULL_DENSE_INDEX ) );
+		_entities.reserve( _entities.size( ) + 1 );
+	}
+
+	/**
+	*	Adds the entity to the end of the dense array.
+	*/
+	inline void InsertEntity( const ComponentEntity &entity )
+	{
+		_sparse [ entity.GetIndex( ) ] = static_cast< uint32_t >( _entities.size( ) );
+		_entities.push_back( entity );
+	}
+
+	/**
+	*	Removes the entity in the given slot by moving the last entity of the dense array into its place.
+	*
+	*	Derived pools move their own per entity data the same way.
+	*/
+	inline void EraseEntity( uint32_t index )
+	{
+		const auto dense = _sparse [ index ];
+
+		// Move the last entity into the hole
+		const auto moved = _entities.back( );
+		_entities [ dense ] = moved;
+		_sparse [ moved.GetIndex( ) ] = dense;
+
+		_entities.pop_back( );
+		_sparse [ index ] = NULL_DENSE_INDEX;
+	}
+
+	/**< Maps entity slots to their position in the dense array. */
+	std::vector<uint32_t> _sparse;
+
+	/**< The entities with a component in the pool. */
+	std::vector<ComponentEntity> _entities;
+};
+
+/**
+*	The component pool of one component type in a component world, along with the sparse set of entities using it.
+*/
+template <typename ComponentType>
+class ComponentWorldPool final : public ComponentWorldPoolBase
+{
+public:
+
+	/**
+	*	Constructs an empty pool.
+	*
+	*	@param resource the memory resource to allocate the chunks of the component pool from, null for the global operator new
+	*/
+	inline explicit ComponentWorldPool( ComponentMemoryResource *resource )
+		: _pool( std::numeric_limits<size_t>::max( ), resource )
+	{
+
+	}
+
+	/**
+	*	Updates all active components of the pool.
+	*/
+	virtual void Update( const float dt ) override
+	{
+		_pool.Update( dt );
+	}
+
+	/**
+	*	Applies pending changes to the components of the pool.
+	*/
+	virtual void LateUpdate( ) override
+	{
+		_pool.LateUpdate( );
+	}
+
+	/**
+	*	Deletes the component of the entity in the given slot, if the entity has one.
+	*/
+	virtual void Remove( uint32_t index ) override
+	{
+		if ( !Contains( index ) )
+			return;
+
+		const auto dense = _sparse [ index ];
+
+		// The component itself goes away at the next late update
+		_pool.Delete( _references [ dense ] );
+
+		// Keep the references parallel to the dense array of entities
+		_references [ dense ] = std::move( _references.back( ) );
+		_references.pop_back( );
+		EraseEntity( index );
+	}
+
+	/**
+	*	Creates a component for the entity.
+	*
+	*	@param entity the entity to create the component for
+	*	@param args the constructor arguments for the component
+	*	@returns the component reference for the component
+	*/
+	template <typename... Args>
+	inline ComponentReference<ComponentType> Add( const ComponentEntity &entity, Args &&... args )
+	{
+		// Entities have at most one component of each type
+		if ( Contains( entity.GetIndex( ) ) )
+			throw std::runtime_error( "Entity already has a component of this type." );
+
+		// Make sure recording the component cannot fail once it exists (may throw)
+		ReserveEntity( entity.GetIndex( ) );
+		_references.reserve( _references.size( ) + 1 );
+
+		// Create the component (may throw)
+		auto reference = _pool.Create( std::forward<Args>( args )... );
+
+		InsertEntity( entity );
+		_references.push_back( reference );
+
+		return reference;
+	}
+
+	/**
+	*	Gets the component of the entity in the given slot, which must be in the pool.
+	*
+	*	Returns null for pools kept in structure of arrays storage.
+	*/
+	inline ComponentType* At( uint32_t index )
+	{
+		return _references [ _sparse [ index ] ].Get( );
+	}
+
+	/**
+	*	Gets the component reference of the entity in the given slot, which must be in the pool.
+	*/
+	inline const ComponentReference<ComponentType>& ReferenceAt( uint32_t index ) const
+	{
+		return _references [ _sparse [ index ] ];
+	}
+
+	/**
+	*	Gets the component pool.
+	*/
+	inline ComponentPool<ComponentType>& GetPool( )
+	{
+		return _pool;
+	}
+
+private:
+
+	/**< The components of the pool. */
+	ComponentPool<ComponentType> _pool;
+
+	/**< The component reference of each entity in the dense array. */
+	std::vector<ComponentReference<ComponentType>> _references;
+};
\ No newline at end of file
@@ -0,0 +1,441 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+#include "ChunkedArray.h"
+#include "ComponentReferenceControlBlock.h"
+
+/**
+*	A ComponentReferenceControlBlock pool that several threads may allocate from and return to at once.
+*
+*	The free list is a lock free stack. Its head packs the index of the first free control block with a counter bumped by 
+*	every change, so a pop whose head was popped and pushed back in the meantime fails instead of linking in a stale next 
+*	index. Free list links are kept in their own array of atomics rather than in the control blocks, whose next index 
+*	belongs to the pending changes list of the component pool. Growing the pool takes a lock, which only happens once every 
+*	chunk of control blocks.
+*
+*	Pools cannot adopt storage owned by someone else, so component pools using this pool cannot be kept in mapped files.
+*/
+template <size_t CHUNK_SIZE>
+class ConcurrentCRCBPool
+{
+public:
+#pragma region
+
+	typedef ComponentReferenceControlBlock ValueType;
+	typedef ValueType* Pointer;
+	typedef const ValueType* ConstPointer;
+	typedef ValueType& Reference;
+	typedef const ValueType& ConstReference;
+	typedef ValueType::IndexType IndexType;
+	typedef std::size_t SizeType;
+	typedef std::ptrdiff_t DifferenceType;
+
+#pragma endregion Allocator Typedefs
+
+	/**< Allocations and deallocations may come from several threads at once. */
+	static const bool CONCURRENT = true;
+
+	/**
+	*	Constructs a concurrent ComponentReferenceControlBlock pool.
+	*
+	*	@param resource the memory resource to allocate chunks of control blocks and links from, null for the global operator new
+	*/
+	inline explicit ConcurrentCRCBPool( ComponentMemoryResource *resource = nullptr )
+		: _pool_head( Pack( ValueType::NULL_INDEX, 0 ) )
+		, _num_allocated( 0 )
+		, _capacity( 0 )
+		, _pool( resource )
+		, _links( resource )
+	{
+
+	}
+
+	/**
+	*	Destroys a concurrent ComponentReferenceControlBlock pool.
+	*/
+	inline ~ConcurrentCRCBPool( ) { }
+
+	/**
+	*	Pool copying is forbidden.
+	*/
+	inline explicit ConcurrentCRCBPool( ConcurrentCRCBPool const& ) = delete;
+
+#pragma region 
+
+	/**
+	*	Gets the control block at the given index.
+	*
+	*	Safe while another thread grows the pool for any index that was handed out before the call.
+	*/
+	inline Reference operator[]( IndexType index ) const { return _pool.At( index ); }
+
+	/**
+	*	Gets the lookups into the pool for component references.
+	*/
+	inline const ChunkedArrayView<ValueType>& GetView( ) const { return _pool; }
+
+	/**
+	*	Gets if the given index names a control block of this pool.
+	*/
+	inline bool IsIndexValid( IndexType index ) const
+	{
+		return index < Capacity( );
+	}
+
+#pragma endregion Address Helpers
+
+#pragma region 
+
+	/**
+	*	Allocates a control block. Thread safe.
+	*
+	*	@returns the index of the allocated control block
+	*/
+	inline IndexType Allocate( SizeType num_objects )
+	{
+		// Ensure the amount of requested objects is 1
+		if ( num_objects != 1 )
+			throw std::runtime_error( "ObjectPools only support allocating one object at a time." );
+
+		for ( ;; )
+		{
+			// Pop the head, retrying until nobody else changed the head under us
+			auto head = _pool_head.load( std::memory_order_acquire );
+			while ( Index( head ) != ValueType::NULL_INDEX )
+			{
+				const auto next = _links.At( Index( head ) ).load( std::memory_order_relaxed );
+				if ( _pool_head.compare_exchange_weak( head, Pack( next, Counter( head ) + 1 ), std::memory_order_acquire, std::memory_order_acquire ) )
+				{
+					_num_allocated.fetch_add( 1, std::memory_order_relaxed );
+					return Index( head );
+				}
+			}
+
+			// Grow the pool as we have no items left to assign (may throw)
+			Grow( );
+		}
+	}
+
+	/**
+	*	Returns the given control block back to the pool. Thread safe.
+	*/
+	inline void Deallocate( IndexType pool_item, SizeType num_objects )
+	{
+		// Ensure the amount of objects returned is only 1
+		if ( num_objects != 1 )
+			throw std::runtime_error( "ObjectPools only support deallocating one object at a time" );
+
+		// Ensure the given pool item index is valid
+		if ( !IsIndexValid( pool_item ) )
+			throw std::runtime_error( "Provided index to deallocate did not appear to be valid for the ObjectPool" );
+
+		Push( pool_item, pool_item );
+		_num_allocated.fetch_sub( 1, std::memory_order_relaxed );
+	}
+
+	/**
+	*	Allocates several control blocks. Thread safe.
+	*
+	*	Either every control block is allocated or none are.
+	*
+	*	@param num_objects the number of control blocks to allocate
+	*	@param pool_items receives the indices of the allocated control blocks
+	*/
+	inline void Allocate( SizeType num_objects, IndexType *pool_items )
+	{
+		SizeType num_popped = 0;
+		try
+		{
+			for ( ; num_popped < num_objects; num_popped++ )
+				pool_items [ num_popped ] = Allocate( 1 );
+		}
+		catch ( ... )
+		{
+			// Return the control blocks popped so far
+			Deallocate( pool_items, num_popped );
+
+			// Rethrow grow exception
+			throw;
+		}
+	}
+
+	/**
+	*	Returns several control blocks back to the pool as one chain. Thread safe.
+	*
+	*	@param pool_items the indices of the control blocks to return
+	*	@param num_objects the number of control blocks to return
+	*/
+	inline void Deallocate( const IndexType *pool_items, SizeType num_objects )
+	{
+		// Ensure every given pool item index is valid before touching the free list
+		for ( SizeType i = 0; i < num_objects; i++ )
+		{
+			if ( !IsIndexValid( pool_items [ i ] ) )
+				throw std::runtime_error( "Provided index to deallocate did not appear to be valid for the ObjectPool" );
+		}
+
+		if ( num_objects == 0 )
+			return;
+
+		// Link the items up and push them with a single exchange
+		for ( SizeType i = 0; i + 1 < num_objects; i++ )
+			_links.At( pool_items [ i ] ).store( pool_items [ i + 1 ], std::memory_order_relaxed );
+
+		Push( pool_items [ 0 ], pool_items [ num_objects - 1 ] );
+		_num_allocated.fetch_sub( num_objects, std::memory_order_relaxed );
+	}
+
+	/**
+	*	Rebuilds the free list after control blocks have been overwritten in place, such as by restoring a snapshot.
+	*
+	*	The lowest free indices are handed out first afterwards. Must not be called while other threads use the pool.
+	*
+	*	@param is_free the function telling if the control block at an index is free
+	*/
+	template <typename Predicate>
+	inline void RelinkFreeList( Predicate is_free )
+	{
+		IndexType head = ValueType::NULL_INDEX;
+		SizeType num_allocated = 0;
+
+		for ( auto index = static_cast< IndexType >( Capacity( ) ); index-- > 0; )
+		{
+			if ( is_free( index ) )
+			{
+				_links.At( index ).store( head, std::memory_order_relaxed );
+				head = index;
+			}
+			else
+			{
+				num_allocated++;
+			}
+		}
+
+		_pool_head.store( Pack( head, Counter( _pool_head.load( ) ) + 1 ) );
+		_num_allocated.store( num_allocated );
+	}
+
+	/**
+	*	Gets the first control block of the free list. Only meaningful while no other thread uses the pool.
+	*/
+	inline IndexType GetFreeListHead( ) const
+	{
+		return Index( _pool_head.load( ) );
+	}
+
+#pragma endregion Memory Allocation
+
+#pragma region
+
+	/**
+	*	Returns the maximum theoretically possible value of n, for which the call allocate(n) could succeed. Thread safe.
+	*
+	*	@returns the maximum number of objects we can allocate storage for at once, counting those the pool can still grow by
+	*/
+	inline SizeType MaxSize( ) const
+	{
+		// The pool can grow until control block indices run out, leaving out the null index
+		return ( ValueType::NULL_INDEX / CHUNK_SIZE ) * CHUNK_SIZE - Size( );
+	}
+
+	/**
+	*	Gets the number of control blocks the pool currently has storage for. Thread safe.
+	*/
+	inline SizeType Capacity( ) const
+	{
+		return _capacity.load( std::memory_order_acquire );
+	}
+
+	/**
+	*	Gets the number of control blocks currently allocated from the pool. Thread safe.
+	*/
+	inline SizeType Size( ) const
+	{
+		return _num_allocated.load( std::memory_order_relaxed );
+	}
+
+	/**
+	*	Ensures the pool has storage for at least the given amount of control blocks. Thread safe.
+	*
+	*	@param capacity the desired capacity
+	*/
+	inline void Reserve( SizeType capacity )
+	{
+		std::lock_guard<std::mutex> lock( _grow_mutex );
+
+		while ( Capacity( ) < capacity )
+			AddChunk( );
+	}
+
+#pragma endregion Size
+
+#pragma region 
+
+	/**
+	*	Constructs the item for the given index.
+	*/
+	inline void Construct( IndexType p, IndexType component_index ) const { ( *this ) [ p ].Initialize( component_index ); };
+
+	/**
+	*	Destroys the item for the given index.
+	*/
+	inline void Destroy( IndexType p ) const { ( *this ) [ p ].Release( ); }
+
+#pragma endregion Construction/Destruction
+
+#pragma region
+
+	/**
+	*	Checks for equality between the given allocators.
+	*/
+	inline bool operator==( ConcurrentCRCBPool const& a ) const
+	{
+		// Is this allocator the same instance
+		return this == std::addressof( a );
+	}
+
+	/**
+	*	Checks for inequality between the given allocators.
+	*/
+	inline bool operator!=( ConcurrentCRCBPool const& a ) const
+	{
+		return !operator==( a );
+	}
+
+#pragma endregion Equality Comparisons
+
+private:
+
+	/**< The free list head, the index of the first free control block in the low half and the change counter in the high half. */
+	typedef uint64_t HeadType;
+
+	/**
+	*	Packs a free list head.
+	*/
+	static inline HeadType Pack( IndexType index, HeadType counter )
+	{
+		return ( counter << 32 ) | index;
+	}
+
+	/**
+	*	Gets the index of the first free control block of a free list head.
+	*/
+	static inline IndexType Index( HeadType head )
+	{
+		return static_cast< IndexType >( head );
+	}
+
+	/**
+	*	Gets the change counter of a free list head.
+	*/
+	static inline HeadType Counter( HeadType head )
+	{
+		return head >> 32;
+	}
+
+	/**
+	*	Pushes a chain of control blocks linked through the free list links onto the free list.
+	*
+	*	@param first the first control block of the chain
+	*	@param last the last control block of the chain
+	*/
+	inline void Push( IndexType first, IndexType last )
+	{
+		// Point the end of the chain to the current head, retrying until nobody else changed the head under us
+		auto head = _pool_head.load( std::memory_order_relaxed );
+		do
+		{
+			_links.At( last ).store( Index( head ), std::memory_order_relaxed );
+		}
+		while ( !_pool_head.compare_exchange_weak( head, Pack( first, Counter( head ) + 1 ), std::memory_order_release, std::memory_order_relaxed ) );
+	}
+
+	/**
+	*	Adds a new chunk of control blocks to the free list, unless another thread refilled it in the meantime.
+	*/
+	inline void Grow( )
+	{
+		std::lock_guard<std::mutex> lock( _grow_mutex );
+
+		if ( Index( _pool_head.load( std::memory_order_acquire ) ) == ValueType::NULL_INDEX )
+			AddChunk( );
+	}
+
+	/**
+	*	Allocates a new chunk of control blocks and pushes them onto the free list. Needs the grow lock.
+	*/
+	inline void AddChunk( )
+	{
+		// Control block indices must fit in an index, leaving out the null index
+		const auto first_index = Capacity( );
+		if ( ValueType::NULL_INDEX - first_index < CHUNK_SIZE )
+			throw std::runtime_error( "Control block pool cannot index any more control blocks." );
+
+		// Allocate the new chunks, keeping any left over by an earlier failure (may throw)
+		if ( _pool.Capacity( ) == first_index )
+			_pool.AddChunk( );
+		if ( _links.Capacity( ) == first_index )
+			_links.AddChunk( );
+
+		// Control blocks own no resources so are never destructed, and neither are their links
+		for ( SizeType i = 0; i < CHUNK_SIZE; i++ )
+		{
+			new ( std::addressof( _pool [ first_index + i ] ) ) ValueType( );
+			new ( std::addressof( _links [ first_index + i ] ) ) std::atomic<IndexType>( static_cast< IndexType >( first_index + i + 1 ) );
+		}
+
+		// Publish the new control blocks before anyone can pop them
+		_capacity.store( first_index + CHUNK_SIZE, std::memory_order_release );
+		Push( static_cast< IndexType >( first_index ), static_cast< IndexType >( first_index + CHUNK_SIZE - 1 ) );
+	}
+
+	/**< The free list head. */
+	std::atomic<HeadType> _pool_head;
+
+	/**< The number of control blocks allocated. */
+	std::atomic<SizeType> _num_allocated;
+
+	/**< The number of control blocks published to other threads. */
+	std::atomic<SizeType> _capacity;
+
+	/**< Guards growing the pool. */
+	std::mutex _grow_mutex;
+
+	/**< The control blocks. */
+	ChunkedArray<ComponentReferenceControlBlock, CHUNK_SIZE> _pool;
+
+	/**< The free list link of each control block, the next free index. */
+	ChunkedArray<std::atomic<IndexType>, CHUNK_SIZE> _links;
+};
\ No newline at end of file
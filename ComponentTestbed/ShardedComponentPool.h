@@ -0,0 +1,264 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "ComponentPool.h"
+
+/**
+*	Splits the components of one type across several independent component pools, called shards.
+*
+*	Each shard has its own active block, control block pool, control table and pending changes list, so shards never 
+*	contend with each other and can be updated and late updated at the same time. Giving each shard its own memory 
+*	resource keeps its chunks local to the NUMA node of the worker that updates it.
+*
+*	Component references name their shard through the locator of the pool that made them, so SetActive and Delete 
+*	route calls to the owning shard from any thread. Recording the change on the pending changes list of the owning 
+*	shard is the hand over between shards, and the change is applied by the next late update of that shard.
+*
+*	Components are created on a chosen shard. Everything else follows the rules of ComponentPool for each shard, 
+*	and individual shards can be reached through GetShard. EG: To set a listener or sort a shard.
+*/
+template <typename ComponentType, typename Traits = ComponentPoolTraits<ComponentType>>
+class ShardedComponentPool final
+{
+public:
+
+	/**< The component pool of each shard. */
+	typedef ComponentPool<ComponentType, Traits> ShardType;
+
+	/**
+	*	Constructs a sharded pool with empty shards.
+	*
+	*	@param num_shards the number of shards, at least one
+	*	@param max_components_per_shard the maximum amount of components each shard should allow for
+	*	@param resources the memory resource of each shard, as for ComponentPool, or null to use the global operator new for every shard
+	*/
+	inline explicit ShardedComponentPool( size_t num_shards, size_t max_components_per_shard = std::numeric_limits<size_t>::max( ), ComponentMemoryResource *const *resources = nullptr )
+	{
+		if ( num_shards == 0 )
+			throw std::runtime_error( "Sharded component pools need at least one shard." );
+
+		_shards.reserve( num_shards );
+		for ( size_t i = 0; i < num_shards; i++ )
+			_shards.push_back( std::unique_ptr<ShardType>( new ShardType( max_components_per_shard, resources ? resources [ i ] : nullptr ) ) );
+	}
+
+	/**
+	*	Sharded pool copying is forbidden.
+	*/
+	ShardedComponentPool( ShardedComponentPool const& ) = delete;
+
+	/**
+	*	Sharded pool copying is forbidden.
+	*/
+	ShardedComponentPool& operator=( ShardedComponentPool const& ) = delete;
+
+	/**
+	*	Gets the number of shards.
+	*/
+	inline size_t GetNumShards( ) const { return _shards.size( ); }
+
+	/**
+	*	Gets a shard.
+	*/
+	inline ShardType& GetShard( size_t shard ) { return *_shards [ shard ]; }
+
+	/**
+	*	Gets the shard that made a component reference. Thread safe.
+	*
+	*	@param component the component to find the shard of
+	*	@returns the index of the shard
+	*/
+	inline size_t GetShardIndex( const ComponentReference<ComponentType> &component ) const
+	{
+		for ( size_t i = 0; i < _shards.size( ); i++ )
+		{
+			if ( _shards [ i ]->Owns( component ) )
+				return i;
+		}
+
+		throw std::runtime_error( "Component reference did not belong to any shard of this component pool." );
+	}
+
+	/**
+	*	Creates a new active component on the given shard.
+	*
+	*	@param shard the index of the shard to create the component on
+	*	@param args the constructor arguments for the component
+	*	@returns the component reference for the component
+	*/
+	template <typename... Args>
+	inline ComponentReference<ComponentType> Create( size_t shard, Args &&... args )
+	{
+		return GetShard( shard ).Create( std::forward<Args>( args )... );
+	}
+
+	/**
+	*	Creates a new active component on the given shard at the end of the frame. Thread safe.
+	*
+	*	@param shard the index of the shard to create the component on
+	*	@param args the constructor arguments for the component
+	*	@returns the component reference for the component
+	*/
+	template <typename... Args>
+	inline ComponentReference<ComponentType> CreateDeferred( size_t shard, Args &&... args )
+	{
+		return GetShard( shard ).CreateDeferred( std::forward<Args>( args )... );
+	}
+
+	/**
+	*	Sets the active state of a component on whichever shard owns it. Thread safe.
+	*
+	*	@param component the component to change the active state of
+	*	@param new_active the new active state of the component
+	*/
+	inline void SetActive( const ComponentReference<ComponentType> &component, const bool new_active )
+	{
+		_shards [ GetShardIndex( component ) ]->SetActive( component, new_active );
+	}
+
+	/**
+	*	Sets a component to be deleted by whichever shard owns it. Thread safe.
+	*
+	*	@param component the component to delete
+	*/
+	inline void Delete( const ComponentReference<ComponentType> &component )
+	{
+		_shards [ GetShardIndex( component ) ]->Delete( component );
+	}
+
+	/**
+	*	Updates the active components of every shard on the calling thread.
+	*
+	*	@param dt the time since the last frame
+	*/
+	inline void Update( const float dt )
+	{
+		for ( auto &shard : _shards )
+			shard->Update( dt );
+	}
+
+	/**
+	*	Updates every shard as a job of its own across the executor, job i updating shard i.
+	*
+	*	Executors must provide Run( num_jobs, job ) as for ComponentPool::ParallelUpdate. Executors that run each job 
+	*	on a fixed worker can pin shards to workers this way. Each shard is updated with Update rather than 
+	*	ParallelUpdate, as the executor is already busy with the shards.
+	*
+	*	@param dt the time since the last frame
+	*	@param executor the executor to run the shard updates on
+	*/
+	template <typename Executor>
+	inline void Update( const float dt, Executor &executor )
+	{
+		executor.Run( _shards.size( ), [ this, dt ] ( size_t job )
+		{
+			_shards [ job ]->Update( dt );
+		} );
+	}
+
+	/**
+	*	Applies the pending changes of every shard on the calling thread.
+	*
+	*	Every shard is late updated even if some throw, and the first exception is passed on afterwards.
+	*/
+	inline void LateUpdate( )
+	{
+		std::exception_ptr exception;
+
+		for ( auto &shard : _shards )
+		{
+			try
+			{
+				shard->LateUpdate( );
+			}
+			catch ( ... )
+			{
+				if ( !exception )
+					exception = std::current_exception( );
+			}
+		}
+
+		if ( exception )
+			std::rethrow_exception( exception );
+	}
+
+	/**
+	*	Applies the pending changes of every shard as a job of its own across the executor, job i late updating shard i.
+	*
+	*	Shards are late updated at the same time, so the constructors and destructors of components they run must not 
+	*	change components of other shards. Every shard is late updated even if some throw, and the exception of the 
+	*	lowest shard is passed on afterwards.
+	*
+	*	@param executor the executor to run the shard late updates on
+	*/
+	template <typename Executor>
+	inline void LateUpdate( Executor &executor )
+	{
+		// Keep the exceptions apart so each job only touches its own (may throw)
+		_exceptions.assign( _shards.size( ), std::exception_ptr( ) );
+
+		executor.Run( _shards.size( ), [ this ] ( size_t job )
+		{
+			try
+			{
+				_shards [ job ]->LateUpdate( );
+			}
+			catch ( ... )
+			{
+				_exceptions [ job ] = std::current_exception( );
+			}
+		} );
+
+		// Pass on the exception of the lowest shard that threw, without keeping any alive
+		std::exception_ptr exception;
+		for ( auto &shard_exception : _exceptions )
+		{
+			if ( !exception )
+				exception = shard_exception;
+		}
+		_exceptions.clear( );
+
+		if ( exception )
+			std::rethrow_exception( exception );
+	}
+
+private:
+
+	/**< The shards. */
+	std::vector<std::unique_ptr<ShardType>> _shards;
+
+	/**< The exception of each shard thrown by the last concurrent late update. */
+	std::vector<std::exception_ptr> _exceptions;
+};
\ No newline at end of file
@@ -0,0 +1,424 @@
+#pragma once
+
+/*
+* Copyright (c) 2015, Missing Box Studio
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+* ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+* (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+* LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+* ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+* (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+* SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ChunkedArray.h"
+#include "ComponentPrefetch.h"
+#include "ComponentRelocation.h"
+
+/**
+*	A compile time sequence of indices, used to expand over the fields of a component.
+*/
+template <size_t... INDICES>
+struct ComponentIndexSequence { };
+
+/**
+*	Makes the index sequence [0, N).
+*/
+template <size_t N, size_t... INDICES>
+struct MakeComponentIndexSequence : MakeComponentIndexSequence<N - 1, N - 1, INDICES...> { };
+
+template <size_t... INDICES>
+struct MakeComponentIndexSequence<0, INDICES...>
+{
+	typedef ComponentIndexSequence<INDICES...> Type;
+};
+
+/**
+*	Checks if all of the given values are true.
+*/
+template <bool... VALUES>
+struct ComponentAllOf;
+
+template <>
+struct ComponentAllOf<> : std::true_type { };
+
+template <bool VALUE, bool... VALUES>
+struct ComponentAllOf<VALUE, VALUES...> : std::integral_constant<bool, VALUE && ComponentAllOf<VALUES...>::value> { };
+
+/**
+*	Stores each field of a component in its own contiguous column of chunks (structure of arrays).
+*
+*	Component types describe their fields with a tuple typedef and update whole runs of columns at once:
+*
+*		struct Particle
+*		{
+*			typedef std::tuple<Vector3, Vector3, float> Fields; // Position, velocity, age
+*
+*			static void UpdateBatch( Vector3 *positions, Vector3 *velocities, float *ages, size_t count, float dt );
+*		};
+*
+*	Components are created with one constructor argument per field (or none to value initialize every field) 
+*	and their fields are accessed through ComponentPool::GetField. There is no component object, so component 
+*	references to structure of arrays components resolve to null.
+*/
+template <typename ComponentType, size_t CHUNK_SIZE, typename Fields = typename ComponentType::Fields>
+class SoAComponentStorage;
+
+template <typename ComponentType, size_t CHUNK_SIZE, typename... FieldTypes>
+class SoAComponentStorage<ComponentType, CHUNK_SIZE, std::tuple<FieldTypes...>>
+{
+	// Assert assumptions over field types
+	static_assert( sizeof...( FieldTypes ) > 0, "Structure of arrays components need at least one field." );
+	static_assert( ComponentAllOf<std::is_nothrow_move_constructible<FieldTypes>::value...>::value, "Component fields must be nothrow move constructible." );
+	static_assert( ComponentAllOf<std::is_nothrow_move_assignable<FieldTypes>::value...>::value, "Component fields must be nothrow move assignable." );
+	static_assert( ComponentAllOf<std::is_nothrow_destructible<FieldTypes>::value...>::value, "Component fields must be nothrow destructible." );
+
+	/**< The indices of all fields. */
+	typedef typename MakeComponentIndexSequence<sizeof...( FieldTypes )>::Type FieldIndices;
+
+public:
+
+	/**< The number of fields of the component. */
+	static const size_t NUM_FIELDS = sizeof...( FieldTypes );
+
+	/**
+	*	Gets the type of a field.
+	*/
+	template <size_t FIELD>
+	struct FieldType
+	{
+		typedef typename std::tuple_element<FIELD, std::tuple<FieldTypes...>>::type Type;
+	};
+
+	/**
+	*	Constructs empty component storage.
+	*
+	*	@param resource the memory resource to allocate the chunks of every column from, null for the global operator new
+	*/
+	inline explicit SoAComponentStorage( ComponentMemoryResource *resource = nullptr )
+		: _columns( ColumnResource<FieldTypes>( resource )... )
+	{
+
+	}
+
+	/**
+	*	Ensures we have storage for at least the given amount of components.
+	*/
+	inline void Reserve( size_t capacity ) { ReserveColumns( capacity, FieldIndices( ) ); }
+
+	/**
+	*	Gets the number of components we currently have storage for.
+	*/
+	inline size_t Capacity( ) const { return CapacityOf( FieldIndices( ) ); }
+
+	/**
+	*	Constructs the fields of a component in the given uninitialized slot.
+	*
+	*	@param index the slot to construct the component in
+	*	@param args one constructor argument per field, or none to value initialize every field
+	*/
+	template <typename... Args>
+	inline void Construct( size_t index, Args &&... args )
+	{
+		static_assert( sizeof...( Args ) == 0 || sizeof...( Args ) == NUM_FIELDS, "Structure of arrays components take one constructor argument per field, or none." );
+
+		ConstructFields( index, FieldIndices( ), std::forward<Args>( args )... );
+	}
+
+	/**
+	*	Destroys the fields of the component in the given slot, leaving the slot uninitialized.
+	*/
+	inline void Destroy( size_t index ) { DestroyFields( index, NUM_FIELDS, FieldIndices( ) ); }
+
+	/**
+	*	Moves a component into an uninitialized slot, leaving its old slot uninitialized.
+	*/
+	inline void Relocate( size_t loc_index, size_t target_index ) { RelocateFields( loc_index, target_index, FieldIndices( ) ); }
+
+	/**
+	*	Swaps the components in two slots, permuting every column.
+	*/
+	inline void Swap( size_t loc_index, size_t target_index ) { SwapFields( loc_index, target_index, FieldIndices( ) ); }
+
+	/**
+	*	Destroys the fields of the components in the given slot range, leaving the slots uninitialized.
+	*/
+	inline void DestroyRange( size_t begin, size_t end ) { DestroyColumns( begin, end, FieldIndices( ) ); }
+
+	/**
+	*	Gets the address control blocks hand out for the component in the given slot. 
+	*
+	*	There is no component object so this is always null.
+	*/
+	inline ComponentType* Address( size_t ) { return nullptr; }
+
+	/**
+	*	Hints that the fields of the component in the given slot will be used soon.
+	*/
+	inline void Prefetch( size_t index ) const { PrefetchFields( index, FieldIndices( ) ); }
+
+	/**
+	*	Gets the lookups into the components for component references.
+	*
+	*	There are no component objects so this is always null.
+	*/
+	inline const ChunkedArrayView<ComponentType>* GetView( ) const { return nullptr; }
+
+	/**
+	*	Gets a field of the component in the given slot.
+	*/
+	template <size_t FIELD>
+	inline typename FieldType<FIELD>::Type& Field( size_t index ) { return std::get<FIELD>( _columns ) [ index ]; }
+
+	/**
+	*	Updates the components in the given slot range, one contiguous run of columns at a time.
+	*/
+	inline void Update( size_t begin, size_t end, const float dt )
+	{
+		while ( begin < end )
+		{
+			// Clamp the run to the end of the chunk
+			const auto offset = begin % CHUNK_SIZE;
+			const auto count = std::min( CHUNK_SIZE - offset, end - begin );
+
+			UpdateColumns( begin, count, dt, FieldIndices( ) );
+
+			begin += count;
+		}
+	}
+
+	/**
+	*	Writes the raw bytes of the slot range [0, count) of every column to the writer, one column after another.
+	*/
+	template <typename Writer>
+	inline void Write( Writer &writer, size_t count ) const
+	{
+		static_assert( ComponentAllOf<std::is_trivially_copyable<FieldTypes>::value...>::value, "Only trivially copyable fields can be serialized." );
+
+		WriteColumns( writer, count, FieldIndices( ) );
+	}
+
+	/**
+	*	Reads the raw bytes of columns written by Write into the uninitialized slot range [0, count).
+	*/
+	template <typename Reader>
+	inline void Read( Reader &reader, size_t count )
+	{
+		static_assert( ComponentAllOf<std::is_trivially_copyable<FieldTypes>::value...>::value, "Only trivially copyable fields can be serialized." );
+
+		ReadColumns( reader, count, FieldIndices( ) );
+	}
+
+	/**
+	*	Rounds the given batch size up so a batch spans a whole number of cache lines in every column.
+	*
+	*	Chunks start on a cache line, so batches aligned to multiples of the batch size never share a cache line.
+	*/
+	static inline size_t AlignBatchSize( size_t batch_size )
+	{
+		const size_t cache_line_size = ChunkedArray<typename FieldType<0>::Type, CHUNK_SIZE>::CACHE_LINE_SIZE;
+		const size_t field_sizes [ ] = { sizeof( FieldTypes )... };
+
+		if ( batch_size > CHUNK_SIZE )
+			batch_size = CHUNK_SIZE;
+
+		// Batch sizes are powers of two, so growing the batch for one field keeps it aligned for the fields before it
+		for ( const auto field_size : field_sizes )
+		{
+			while ( batch_size < CHUNK_SIZE && ( batch_size * field_size ) % cache_line_size != 0 )
+				batch_size *= 2;
+		}
+
+		return batch_size;
+	}
+
+private:
+
+	template <size_t... FIELDS>
+	inline void ReserveColumns( size_t capacity, ComponentIndexSequence<FIELDS...> )
+	{
+		int expand [ ] = { 0, ( std::get<FIELDS>( _columns ).Reserve( capacity ), 0 )... };
+		( void ) expand;
+	}
+
+	template <size_t... FIELDS>
+	inline size_t CapacityOf( ComponentIndexSequence<FIELDS...> ) const
+	{
+		// A failed reserve may leave some columns larger than others
+		const size_t capacities [ ] = { std::get<FIELDS>( _columns ).Capacity( )... };
+		return *std::min_element( capacities, capacities + NUM_FIELDS );
+	}
+
+	template <size_t... FIELDS, typename... Args>
+	inline void ConstructFields( size_t index, ComponentIndexSequence<FIELDS...>, Args &&... args )
+	{
+		size_t constructed = 0;
+		try
+		{
+			int expand [ ] = { 0, ( ConstructField<FIELDS>( index, std::forward<Args>( args ) ), ++constructed, 0 )... };
+			( void ) expand;
+		}
+		catch ( ... )
+		{
+			// Clean up the fields we did manage to construct
+			DestroyFields( index, constructed, FieldIndices( ) );
+			throw;
+		}
+	}
+
+	template <size_t... FIELDS>
+	inline void ConstructFields( size_t index, ComponentIndexSequence<FIELDS...> )
+	{
+		size_t constructed = 0;
+		try
+		{
+			int expand [ ] = { 0, ( ConstructField<FIELDS>( index ), ++constructed, 0 )... };
+			( void ) expand;
+		}
+		catch ( ... )
+		{
+			// Clean up the fields we did manage to construct
+			DestroyFields( index, constructed, FieldIndices( ) );
+			throw;
+		}
+	}
+
+	template <size_t FIELD, typename... Args>
+	inline void ConstructField( size_t index, Args &&... args )
+	{
+		typedef typename FieldType<FIELD>::Type Type;
+		new ( std::addressof( Field<FIELD>( index ) ) ) Type( std::forward<Args>( args )... );
+	}
+
+	template <size_t... FIELDS>
+	inline void DestroyFields( size_t index, size_t count, ComponentIndexSequence<FIELDS...> )
+	{
+		int expand [ ] = { 0, ( FIELDS < count ? ( DestroyField<FIELDS>( index ), 0 ) : 0 )... };
+		( void ) expand;
+	}
+
+	template <size_t FIELD>
+	inline void DestroyField( size_t index )
+	{
+		typedef typename FieldType<FIELD>::Type Type;
+		Field<FIELD>( index ).~Type( );
+	}
+
+	template <typename Field>
+	static inline ComponentMemoryResource* ColumnResource( ComponentMemoryResource *resource ) { return resource; }
+
+	template <size_t... FIELDS>
+	inline void DestroyColumns( size_t begin, size_t end, ComponentIndexSequence<FIELDS...> )
+	{
+		int expand [ ] = { 0, ( DestroyColumn<FIELDS>( begin, end, std::integral_constant<bool, std::is_trivially_destructible<typename FieldType<FIELDS>::Type>::value>( ) ), 0 )... };
+		( void ) expand;
+	}
+
+	template <size_t FIELD>
+	inline void DestroyColumn( size_t, size_t, std::true_type ) { }
+
+	template <size_t FIELD>
+	inline void DestroyColumn( size_t begin, size_t end, std::false_type )
+	{
+		for ( auto i = begin; i < end; i++ )
+			DestroyField<FIELD>( i );
+	}
+
+	template <size_t... FIELDS>
+	inline void RelocateFields( size_t loc_index, size_t target_index, ComponentIndexSequence<FIELDS...> )
+	{
+		int expand [ ] = { 0, ( RelocateField<FIELDS>( loc_index, target_index ), 0 )... };
+		( void ) expand;
+	}
+
+	template <size_t FIELD>
+	inline void RelocateField( size_t loc_index, size_t target_index )
+	{
+		typedef typename FieldType<FIELD>::Type Type;
+		ComponentRelocation<Type>::Relocate( std::addressof( Field<FIELD>( loc_index ) ), std::addressof( Field<FIELD>( target_index ) ) );
+	}
+
+	template <size_t... FIELDS>
+	inline void SwapFields( size_t loc_index, size_t target_index, ComponentIndexSequence<FIELDS...> )
+	{
+		int expand [ ] = { 0, ( ComponentRelocation<typename FieldType<FIELDS>::Type>::Swap( Field<FIELDS>( loc_index ), Field<FIELDS>( target_index ) ), 0 )... };
+		( void ) expand;
+	}
+
+	template <size_t... FIELDS>
+	inline void PrefetchFields( size_t index, ComponentIndexSequence<FIELDS...> ) const
+	{
+		int expand [ ] = { 0, ( PrefetchField<FIELDS>( index ), 0 )... };
+		( void ) expand;
+	}
+
+	template <size_t FIELD>
+	inline void PrefetchField( size_t index ) const
+	{
+		COMPONENT_PREFETCH( std::addressof( std::get<FIELD>( _columns ) [ index ] ) );
+	}
+
+	template <typename Writer, size_t... FIELDS>
+	inline void WriteColumns( Writer &writer, size_t count, ComponentIndexSequence<FIELDS...> ) const
+	{
+		int expand [ ] = { 0, ( WriteColumn<FIELDS>( writer, count ), 0 )... };
+		( void ) expand;
+	}
+
+	template <size_t FIELD, typename Writer>
+	inline void WriteColumn( Writer &writer, size_t count ) const
+	{
+		typedef typename FieldType<FIELD>::Type Type;
+		std::get<FIELD>( _columns ).ForEachSpan( 0, count, [ &writer ] ( const Type *fields, size_t num_fields )
+		{
+			writer.Write( fields, num_fields * sizeof( Type ) );
+		} );
+	}
+
+	template <typename Reader, size_t... FIELDS>
+	inline void ReadColumns( Reader &reader, size_t count, ComponentIndexSequence<FIELDS...> )
+	{
+		int expand [ ] = { 0, ( ReadColumn<FIELDS>( reader, count ), 0 )... };
+		( void ) expand;
+	}
+
+	template <size_t FIELD, typename Reader>
+	inline void ReadColumn( Reader &reader, size_t count )
+	{
+		typedef typename FieldType<FIELD>::Type Type;
+		std::get<FIELD>( _columns ).ForEachSpan( 0, count, [ &reader ] ( Type *fields, size_t num_fields )
+		{
+			reader.Read( fields, num_fields * sizeof( Type ) );
+		} );
+	}
+
+	template <size_t... FIELDS>
+	inline void UpdateColumns( size_t index, size_t count, const float dt, ComponentIndexSequence<FIELDS...> )
+	{
+		ComponentType::UpdateBatch( std::addressof( Field<FIELDS>( index ) )..., count, dt );
+	}
+
+	/**< One column of field slots per field. */
+	std::tuple<ChunkedArray<FieldTypes, CHUNK_SIZE>...> _columns;
+};